@@ -0,0 +1,152 @@
+use serde::Serialize;
+use std::collections::VecDeque;
+use std::time::{SystemTime, UNIX_EPOCH};
+
+// Rounds kept for the drift fit; at one round every 30 s this spans ~16 min
+const HISTORY_LEN: usize = 32;
+
+// Rounds must span at least this long before drift is estimated
+const MIN_DRIFT_SPAN_US: f64 = 5_000_000.0;
+
+/// Host wall-clock time in microseconds since the Unix epoch, the timeline
+/// shared with video/audio recordings and other controllers.
+pub fn host_now_us() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_micros() as u64)
+        .unwrap_or(0)
+}
+
+/// One time_sync exchange: host send/receive times around the device's
+/// request-arrival and reply-departure times (NTP t0..t3).
+#[derive(Clone, Copy, Debug)]
+pub struct SyncSample {
+    pub host_send_us: u64,
+    pub device_rx_us: u64,
+    pub device_tx_us: u64,
+    pub host_recv_us: u64,
+}
+
+impl SyncSample {
+    /// Round trip spent on the wire, excluding device processing
+    fn delay_us(&self) -> f64 {
+        (self.host_recv_us as f64 - self.host_send_us as f64)
+            - (self.device_tx_us as f64 - self.device_rx_us as f64)
+    }
+
+    /// Device minus host clock, assuming a symmetric path
+    fn offset_us(&self) -> f64 {
+        let device_mid = (self.device_rx_us as f64 + self.device_tx_us as f64) / 2.0;
+        let host_mid = (self.host_send_us as f64 + self.host_recv_us as f64) / 2.0;
+        device_mid - host_mid
+    }
+
+    fn host_mid_us(&self) -> f64 {
+        (self.host_send_us as f64 + self.host_recv_us as f64) / 2.0
+    }
+}
+
+#[derive(Serialize, Clone, Debug)]
+pub struct SyncEstimate {
+    /// Device minus host clock at the latest round
+    pub offset_us: f64,
+    /// Device clock rate error relative to the host, parts per million
+    pub drift_ppm: f64,
+    /// Round-trip delay of the sample used; the offset error is within half of it
+    pub delay_us: f64,
+    pub rounds: usize,
+}
+
+/// Offset and drift between the host clock and the device's time_us_64.
+/// Each round of exchanges contributes its minimum-delay sample; a line
+/// fitted through the rounds gives the drift.
+#[derive(Default)]
+pub struct ClockSync {
+    // (host time, offset) per round
+    history: VecDeque<(f64, f64)>,
+    last_delay_us: f64,
+}
+
+impl ClockSync {
+    pub fn reset(&mut self) {
+        self.history.clear();
+        self.last_delay_us = 0.0;
+    }
+
+    pub fn add_round(&mut self, samples: &[SyncSample]) -> Option<SyncEstimate> {
+        let best = samples
+            .iter()
+            .filter(|s| s.delay_us() >= 0.0)
+            .min_by(|a, b| a.delay_us().total_cmp(&b.delay_us()))?;
+
+        if self.history.len() == HISTORY_LEN {
+            self.history.pop_front();
+        }
+        self.history.push_back((best.host_mid_us(), best.offset_us()));
+        self.last_delay_us = best.delay_us();
+        self.estimate()
+    }
+
+    /// Least-squares offset line; slope is the drift in µs per µs
+    fn fit(&self) -> Option<(f64, f64, f64)> {
+        let n = self.history.len();
+        if n == 0 {
+            return None;
+        }
+
+        let mean_host = self.history.iter().map(|(h, _)| h).sum::<f64>() / n as f64;
+        let mean_offset = self.history.iter().map(|(_, o)| o).sum::<f64>() / n as f64;
+
+        let span = self.history.back()?.0 - self.history.front()?.0;
+        if n < 2 || span < MIN_DRIFT_SPAN_US {
+            // Too short to tell drift from noise; hold the latest offset
+            let (host, offset) = *self.history.back()?;
+            return Some((host, offset, 0.0));
+        }
+
+        let mut num = 0.0;
+        let mut den = 0.0;
+        for (h, o) in &self.history {
+            num += (h - mean_host) * (o - mean_offset);
+            den += (h - mean_host) * (h - mean_host);
+        }
+        let slope = if den > 0.0 { num / den } else { 0.0 };
+        Some((mean_host, mean_offset, slope))
+    }
+
+    pub fn estimate(&self) -> Option<SyncEstimate> {
+        let (ref_host, ref_offset, slope) = self.fit()?;
+        let latest_host = self.history.back()?.0;
+        Some(SyncEstimate {
+            offset_us: ref_offset + slope * (latest_host - ref_host),
+            drift_ppm: slope * 1e6,
+            delay_us: self.last_delay_us,
+            rounds: self.history.len(),
+        })
+    }
+
+    /// Maps a device time_us_64 timestamp onto the host timeline
+    pub fn device_to_host_us(&self, device_us: u64) -> Option<u64> {
+        let (ref_host, ref_offset, slope) = self.fit()?;
+        // device = host + ref_offset + slope * (host - ref_host), solved for host
+        let host = (device_us as f64 - ref_offset + slope * ref_host) / (1.0 + slope);
+        (host >= 0.0).then_some(host.round() as u64)
+    }
+}
+
+/// Parses "time_sync: token=<n> rx=<us> tx=<us>"
+pub fn parse_reply(line: &str) -> Option<(u32, u64, u64)> {
+    let rest = line.strip_prefix("time_sync:")?;
+    let mut token = None;
+    let mut rx = None;
+    let mut tx = None;
+    for field in rest.split_whitespace() {
+        match field.split_once('=') {
+            Some(("token", v)) => token = v.parse().ok(),
+            Some(("rx", v)) => rx = v.parse().ok(),
+            Some(("tx", v)) => tx = v.parse().ok(),
+            _ => {}
+        }
+    }
+    Some((token?, rx?, tx?))
+}
@@ -1,10 +1,15 @@
+mod clock_sync;
+
+use clock_sync::{host_now_us, ClockSync, SyncEstimate, SyncSample};
 use serde::{Deserialize, Serialize};
 use serialport::{available_ports, SerialPortType};
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::Arc;
+use std::thread::JoinHandle;
 use std::time::Duration;
-use tauri::State;
-use std::io::Write;
-use tokio::sync::Mutex;
+use tauri::{AppHandle, Emitter, State};
+use std::io::{Read, Write};
+use tokio::sync::{mpsc, Mutex};
 
 #[derive(Serialize, Deserialize, Debug)]
 struct SerialPortInfo {
@@ -12,8 +17,90 @@ struct SerialPortInfo {
     path: String,
 }
 
+#[derive(Serialize, Clone, Debug)]
+struct SerialLine {
+    line: String,
+}
+
+// Dedicated thread that owns a clone of the port, so reads never contend
+// with writes for the connection lock
+struct SerialReader {
+    stop: Arc<AtomicBool>,
+    thread: JoinHandle<()>,
+}
+
 struct SerialConnection {
     port: Option<Box<dyn serialport::SerialPort + Send>>,
+    reader: Option<SerialReader>,
+}
+
+// time_sync replies are routed to the pending sync_clock call instead of the
+// frontend, stamped with the host time their bytes were read
+type SyncReply = (String, u64);
+
+struct ClockSyncState {
+    waiter: std::sync::Mutex<Option<mpsc::UnboundedSender<SyncReply>>>,
+    clock: std::sync::Mutex<ClockSync>,
+}
+
+type SyncState = Arc<ClockSyncState>;
+
+// Probes per sync_clock round; the one with the shortest round trip is kept
+const SYNC_PROBES: u32 = 8;
+const SYNC_REPLY_TIMEOUT: Duration = Duration::from_millis(250);
+
+// How long a blocking read waits before re-checking the stop flag; bytes are
+// returned as soon as they arrive
+const READER_POLL_TIMEOUT: Duration = Duration::from_millis(50);
+
+fn spawn_reader(app: AppHandle, sync: SyncState, mut port: Box<dyn serialport::SerialPort>) -> SerialReader {
+    let stop = Arc::new(AtomicBool::new(false));
+    let thread_stop = stop.clone();
+
+    let thread = std::thread::spawn(move || {
+        let mut buffer = [0u8; 1024];
+        let mut line = Vec::with_capacity(256);
+
+        while !thread_stop.load(Ordering::Relaxed) {
+            match port.read(&mut buffer) {
+                Ok(n) => {
+                    let read_us = host_now_us();
+                    for &byte in &buffer[..n] {
+                        if byte != b'\n' {
+                            line.push(byte);
+                            continue;
+                        }
+                        let text = String::from_utf8_lossy(&line).trim_end_matches('\r').to_string();
+                        line.clear();
+                        if text.starts_with("time_sync:") {
+                            if let Some(waiter) = sync.waiter.lock().unwrap().as_ref() {
+                                let _ = waiter.send((text, read_us));
+                            }
+                        } else if !text.is_empty() {
+                            let _ = app.emit("serial-line", SerialLine { line: text });
+                        }
+                    }
+                }
+                Err(e) if e.kind() == std::io::ErrorKind::TimedOut => {}
+                Err(e) => {
+                    if !thread_stop.load(Ordering::Relaxed) {
+                        let _ = app.emit("serial-error", format!("Failed to read data: {e}"));
+                    }
+                    break;
+                }
+            }
+        }
+    });
+
+    SerialReader { stop, thread }
+}
+
+async fn stop_reader(reader: Option<SerialReader>) {
+    if let Some(reader) = reader {
+        reader.stop.store(true, Ordering::Relaxed);
+        // The thread exits within one poll timeout; wait so the port is free
+        let _ = tokio::task::spawn_blocking(move || reader.thread.join()).await;
+    }
 }
 
 type SerialState = Arc<Mutex<SerialConnection>>;
@@ -22,7 +109,7 @@ type SerialState = Arc<Mutex<SerialConnection>>;
 fn list_serial_ports() -> Result<Vec<SerialPortInfo>, String> {
     match available_ports() {
         Ok(ports) => {
-            let port_list: Vec<SerialPortInfo> = ports
+            let mut port_list: Vec<SerialPortInfo> = ports
                 .into_iter()
                 .map(|p| {
                     let name = match &p.port_type {
@@ -41,6 +128,14 @@ fn list_serial_ports() -> Result<Vec<SerialPortInfo>, String> {
                     }
                 })
                 .collect();
+            // Pseudo-terminals aren't enumerated; the firmware simulator's
+            // console (pico-firmware/host/sim_main.cpp) is listed by path
+            if let Ok(path) = std::env::var("FEUD_SIM_PORT") {
+                port_list.push(SerialPortInfo {
+                    name: format!("{path} (Simulator)"),
+                    path,
+                });
+            }
             Ok(port_list)
         }
         Err(e) => Err(format!("Failed to list serial ports: {e}")),
@@ -48,30 +143,43 @@ fn list_serial_ports() -> Result<Vec<SerialPortInfo>, String> {
 }
 
 #[tauri::command]
-async fn connect_serial(port_path: String, state: State<'_, SerialState>) -> Result<String, String> {
+async fn connect_serial(
+    port_path: String,
+    app: AppHandle,
+    state: State<'_, SerialState>,
+    sync: State<'_, SyncState>,
+) -> Result<String, String> {
     let mut connection = state.lock().await;
     
     // Close existing connection if any
-    if connection.port.is_some() {
-        connection.port = None;
-    }
+    stop_reader(connection.reader.take()).await;
+    connection.port = None;
 
     // Open new connection
-    match serialport::new(&port_path, 115200)
+    let port = serialport::new(&port_path, 115200)
         .timeout(Duration::from_millis(1000))
         .open()
-    {
-        Ok(port) => {
-            connection.port = Some(port);
-            Ok(format!("Connected to {port_path}"))
-        }
-        Err(e) => Err(format!("Failed to connect: {e}")),
-    }
+        .map_err(|e| format!("Failed to connect: {e}"))?;
+
+    let mut reader_port = port
+        .try_clone()
+        .map_err(|e| format!("Failed to connect: {e}"))?;
+    reader_port
+        .set_timeout(READER_POLL_TIMEOUT)
+        .map_err(|e| format!("Failed to connect: {e}"))?;
+
+    // A different or rebooted device has its own timeline
+    sync.clock.lock().unwrap().reset();
+
+    connection.reader = Some(spawn_reader(app, sync.inner().clone(), reader_port));
+    connection.port = Some(port);
+    Ok(format!("Connected to {port_path}"))
 }
 
 #[tauri::command]
 async fn disconnect_serial(state: State<'_, SerialState>) -> Result<String, String> {
     let mut connection = state.lock().await;
+    stop_reader(connection.reader.take()).await;
     connection.port = None;
     Ok("Disconnected".to_string())
 }
@@ -91,51 +199,107 @@ async fn send_serial_data(data: Vec<u8>, state: State<'_, SerialState>) -> Resul
     }
 }
 
-#[tauri::command]
-async fn read_serial_data(state: State<'_, SerialState>) -> Result<Vec<u8>, String> {
-    // Try to acquire the lock with a timeout to avoid blocking other operations
-    let connection_result = tokio::time::timeout(
-        Duration::from_millis(50),
-        state.lock()
-    ).await;
-    
-    let mut connection = match connection_result {
-        Ok(conn) => conn,
-        Err(_) => return Ok(vec![]), // Return empty if we can't get lock quickly
+// One exchange: host send time, then the device's rx/tx and our read time
+async fn sync_probe(
+    token: u32,
+    state: &State<'_, SerialState>,
+    replies: &mut mpsc::UnboundedReceiver<SyncReply>,
+) -> Result<Option<SyncSample>, String> {
+    let host_send_us = {
+        let mut connection = state.lock().await;
+        let port = connection
+            .port
+            .as_mut()
+            .ok_or_else(|| "Not connected to any serial port".to_string())?;
+        let host_send_us = host_now_us();
+        port.write_all(format!("time_sync {token}\n").as_bytes())
+            .map_err(|e| format!("Failed to send data: {e}"))?;
+        port.flush()
+            .map_err(|e| format!("Failed to flush data: {e}"))?;
+        host_send_us
     };
-    
-    if let Some(ref mut port) = connection.port {
-        // Perform a non-blocking read
-        let mut buffer = vec![0; 1024];
-        match port.read(&mut buffer) {
-            Ok(n) => {
-                buffer.truncate(n);
-                Ok(buffer)
+
+    let deadline = tokio::time::Instant::now() + SYNC_REPLY_TIMEOUT;
+    loop {
+        let reply = match tokio::time::timeout_at(deadline, replies.recv()).await {
+            Ok(Some(reply)) => reply,
+            _ => return Ok(None),
+        };
+        // Late replies to an earlier probe carry an older token
+        if let Some((reply_token, device_rx_us, device_tx_us)) = clock_sync::parse_reply(&reply.0) {
+            if reply_token == token {
+                return Ok(Some(SyncSample {
+                    host_send_us,
+                    device_rx_us,
+                    device_tx_us,
+                    host_recv_us: reply.1,
+                }));
             }
+        }
+    }
+}
+
+#[tauri::command]
+async fn sync_clock(
+    state: State<'_, SerialState>,
+    sync: State<'_, SyncState>,
+) -> Result<SyncEstimate, String> {
+    let (sender, mut replies) = mpsc::unbounded_channel();
+    *sync.waiter.lock().unwrap() = Some(sender);
+
+    let mut samples = Vec::with_capacity(SYNC_PROBES as usize);
+    let mut result = Ok(());
+    for token in 0..SYNC_PROBES {
+        match sync_probe(token, &state, &mut replies).await {
+            Ok(Some(sample)) => samples.push(sample),
+            Ok(None) => {}
             Err(e) => {
-                if e.kind() == std::io::ErrorKind::TimedOut {
-                    Ok(vec![])
-                } else {
-                    Err(format!("Failed to read data: {e}"))
-                }
+                result = Err(e);
+                break;
             }
         }
-    } else {
-        Err("Not connected to any serial port".to_string())
     }
+    *sync.waiter.lock().unwrap() = None;
+    result?;
+
+    sync.clock
+        .lock()
+        .unwrap()
+        .add_round(&samples)
+        .ok_or_else(|| "No time_sync replies from device".to_string())
+}
+
+// Maps a device time_us_64 stamp (e.g. press_t) to host epoch microseconds
+#[tauri::command]
+fn device_to_host_time(device_us: u64, sync: State<'_, SyncState>) -> Option<u64> {
+    sync.clock.lock().unwrap().device_to_host_us(device_us)
+}
+
+#[tauri::command]
+fn clock_sync_status(sync: State<'_, SyncState>) -> Option<SyncEstimate> {
+    sync.clock.lock().unwrap().estimate()
 }
 
 #[cfg_attr(mobile, tauri::mobile_entry_point)]
 pub fn run() {
     tauri::Builder::default()
         .plugin(tauri_plugin_opener::init())
-        .manage(Arc::new(Mutex::new(SerialConnection { port: None })))
+        .manage(Arc::new(Mutex::new(SerialConnection {
+            port: None,
+            reader: None,
+        })))
+        .manage(Arc::new(ClockSyncState {
+            waiter: std::sync::Mutex::new(None),
+            clock: std::sync::Mutex::new(ClockSync::default()),
+        }))
         .invoke_handler(tauri::generate_handler![
             list_serial_ports,
             connect_serial,
             disconnect_serial,
             send_serial_data,
-            read_serial_data
+            sync_clock,
+            device_to_host_time,
+            clock_sync_status
         ])
         .run(tauri::generate_context!())
         .expect("error while running tauri application");
@@ -0,0 +1,177 @@
+#include "audio_output.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "clock_governor.h"
+#include "pio_manager.h"
+#include "hot_path.h"
+
+AudioOutput& AudioOutput::instance() {
+    static AudioOutput audio;
+    if (!audio.initialized) {
+        audio.initialized = true;
+        audio.init();
+    }
+    return audio;
+}
+
+void AudioOutput::init() {
+    build_waves();
+    
+    gpio_set_function(AUDIO_PIN, GPIO_FUNC_PWM);
+    slice = pwm_gpio_to_slice_num(AUDIO_PIN);
+    
+    // Full clk_sys, 8-bit: a carrier of several hundred kHz, far above audio
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, 1);
+    pwm_config_set_wrap(&config, PWM_WRAP);
+    pwm_init(slice, &config, true);
+    for (uint16_t level = 0; level < PWM_MIDPOINT; level++) {
+        pwm_set_chan_level(slice, pwm_gpio_to_channel(AUDIO_PIN), level);
+        busy_wait_us_32(RAMP_STEP_US);
+    }
+    silence();
+    
+    dma_channel = PioManager::instance().claim_dma("audio", true);
+    dma_timer = dma_claim_unused_timer(true);
+    
+    note_config = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&note_config, DMA_SIZE_16);
+    channel_config_set_read_increment(&note_config, true);
+    channel_config_set_write_increment(&note_config, false);
+    channel_config_set_ring(&note_config, false, WAVE_RING_BITS);
+    channel_config_set_dreq(&note_config, dma_get_timer_dreq(dma_timer));
+    
+    // The timer pacing follows clk_sys, so a switch need not wait for a sound
+    ClockGovernor& governor = ClockGovernor::instance();
+    governor.exempt_from_drain(dma_channel);
+    governor.add_listener(on_clock_change);
+    on_clock_change(clock_get_hz(clk_sys));
+}
+
+void AudioOutput::build_waves() {
+    const float amplitude = volume / 2.0f;
+    
+    for (uint i = 0; i < WAVE_SAMPLES; i++) {
+        const float phase = (float)i / WAVE_SAMPLES;
+        
+        // Buzzer: square fundamental with a sawtooth third for the rasp
+        const float square = (phase < 0.5f) ? 1.0f : -1.0f;
+        const float saw = 2.0f * (phase * 3.0f - floorf(phase * 3.0f)) - 1.0f;
+        const float buzz = 0.65f * square + 0.35f * saw;
+        waves[(size_t)Wave::BUZZ][i] = std::clamp<int>(PWM_MIDPOINT + lrintf(amplitude * buzz), 0, PWM_WRAP);
+        
+        for (uint cycles = 2; cycles <= 4; cycles++) {
+            const float tone = sinf(2.0f * (float)M_PI * phase * cycles);
+            waves[(size_t)Wave::TONE_2 + (cycles - 2)][i] = std::clamp<int>(PWM_MIDPOINT + lrintf(amplitude * tone), 0, PWM_WRAP);
+        }
+        
+        waves[(size_t)Wave::SILENCE][i] = PWM_MIDPOINT;
+    }
+}
+
+void AudioOutput::on_clock_change(uint32_t sys_hz) {
+    AudioOutput& audio = AudioOutput::instance();
+    dma_timer_set_fraction(audio.dma_timer, 1, (sys_hz + SAMPLE_RATE_HZ / 2) / SAMPLE_RATE_HZ);
+}
+
+void AudioOutput::silence() {
+    pwm_set_chan_level(slice, pwm_gpio_to_channel(AUDIO_PIN), PWM_MIDPOINT);
+}
+
+void HOT_PATH_FUNC(AudioOutput::start_note)(const Note& note) {
+    // 16-bit writes are replicated into both halves of CC; channel A's pin is not a PWM output
+    const uint32_t samples = (uint32_t)note.duration_ms * SAMPLE_RATE_HZ / 1000;
+    dma_channel_configure(dma_channel, &note_config, &pwm_hw->slice[slice].cc, waves[(size_t)note.wave].data(), samples, true);
+}
+
+void HOT_PATH_FUNC(AudioOutput::play)(Sound sound) {
+    static constexpr Note buzzer[] = {
+        {Wave::BUZZ, 1000},
+    };
+    static constexpr Note timer_expired[] = {
+        {Wave::TONE_4, 150},
+        {Wave::SILENCE, 60},
+        {Wave::TONE_3, 150},
+        {Wave::SILENCE, 60},
+        {Wave::TONE_2, 450},
+    };
+    
+    if (!enabled || dma_channel < 0) return;
+    
+    const uint32_t start = time_us_32();
+    const uint32_t irq_state = save_and_disable_interrupts();
+    
+    dma_channel_abort(dma_channel);
+    switch (sound) {
+        case Sound::BUZZER:
+            notes = buzzer;
+            note_count = std::size(buzzer);
+            break;
+        case Sound::TIMER_EXPIRED:
+        default:
+            notes = timer_expired;
+            note_count = std::size(timer_expired);
+            break;
+    }
+    note_index = 0;
+    start_note(notes[0]);
+    
+    restore_interrupts(irq_state);
+    last_start_us = time_us_32() - start;
+    plays++;
+}
+
+void AudioOutput::stop() {
+    const uint32_t irq_state = save_and_disable_interrupts();
+    if (dma_channel >= 0) {
+        dma_channel_abort(dma_channel);
+    }
+    notes = nullptr;
+    silence();
+    restore_interrupts(irq_state);
+}
+
+void AudioOutput::update() {
+    if (!notes || dma_channel_is_busy(dma_channel)) return;
+    
+    // A play() from an interrupt may replace the sound meanwhile
+    const uint32_t irq_state = save_and_disable_interrupts();
+    if (notes && !dma_channel_is_busy(dma_channel)) {
+        if (++note_index < note_count) {
+            start_note(notes[note_index]);
+        } else {
+            notes = nullptr;
+            silence();
+        }
+    }
+    restore_interrupts(irq_state);
+}
+
+void AudioOutput::set_enabled(bool on) {
+    enabled = on;
+    if (!enabled) {
+        stop();
+    }
+}
+
+void AudioOutput::set_volume(uint8_t level) {
+    stop();
+    volume = level;
+    build_waves();
+}
+
+const char* AudioOutput::sound_name(Sound sound) {
+    switch (sound) {
+        case Sound::BUZZER: return "buzzer";
+        case Sound::TIMER_EXPIRED: return "expired";
+        default: return "?";
+    }
+}
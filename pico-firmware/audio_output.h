@@ -0,0 +1,104 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+
+// Audio output pin; PWM slice 4 channel B (pin 8 stays the level shifter enable)
+constexpr uint AUDIO_PIN = 9;
+
+enum class Sound : uint8_t {
+    BUZZER,         // Player press
+    TIMER_EXPIRED,  // Round timer ran out
+    COUNT
+};
+
+// On-device sound effects. PWM on AUDIO_PIN carries 8-bit samples that a
+// DMA channel writes into the compare register, paced by a DMA timer at
+// SAMPLE_RATE_HZ. Sounds are synthesized at init into single-period wave
+// tables in RAM (flash is unavailable to DMA during config writes); a
+// note plays one table in ring mode for its duration, so play() only has
+// to start a DMA transfer and the sound begins microseconds after the
+// press or expiry that triggered it. Multi-note sounds are advanced from
+// the main loop.
+class AudioOutput {
+ private:
+    bool initialized = false;
+    bool enabled = true;
+    uint8_t volume = 192;
+    
+    static constexpr uint32_t SAMPLE_RATE_HZ = 16000;
+    static constexpr uint16_t PWM_WRAP = 255;
+    
+    // Every wave is centred here, and the output idles here between sounds,
+    // so a sound starts and ends without a step. Boot ramps up to it.
+    static constexpr uint16_t PWM_MIDPOINT = 128;
+    static constexpr uint32_t RAMP_STEP_US = 100;
+    
+    // One wave table period: 128 16-bit samples fill a 256-byte DMA ring,
+    // so a table with k cycles plays at k * 125Hz
+    static constexpr uint WAVE_SAMPLES = 128;
+    static constexpr uint WAVE_RING_BITS = 8;
+    using WaveTable = std::array<uint16_t, WAVE_SAMPLES>;
+    
+    enum class Wave : uint8_t {
+        BUZZ,
+        TONE_2,
+        TONE_3,
+        TONE_4,
+        SILENCE,
+        COUNT
+    };
+    alignas(1u << WAVE_RING_BITS) std::array<WaveTable, (size_t)Wave::COUNT> waves{};
+    
+    struct Note {
+        Wave wave;
+        uint16_t duration_ms;
+    };
+    
+    uint slice = 0;
+    int dma_channel = -1;
+    int dma_timer = -1;
+    dma_channel_config note_config{};  // Built in init(); the SDK builder is in flash
+    
+    // Current sound
+    const Note* notes = nullptr;
+    size_t note_count = 0;
+    size_t note_index = 0;
+    
+    // Statistics
+    uint32_t plays = 0;
+    uint32_t last_start_us = 0;  // play() to first sample request
+    
+    void init();
+    void build_waves();
+    void start_note(const Note& note);
+    void silence();
+    static void on_clock_change(uint32_t sys_hz);
+
+ public:
+    static AudioOutput& instance();
+    
+    // Safe from interrupt context; a new sound replaces the current one
+    void play(Sound sound);
+    void stop();
+    
+    // Advances multi-note sounds; call from the main loop
+    void update();
+    
+    void set_enabled(bool on);
+    void set_volume(uint8_t level);
+    
+    bool is_enabled() const { return enabled; }
+    bool is_playing() const { return notes != nullptr; }
+    uint8_t get_volume() const { return volume; }
+    uint32_t get_plays() const { return plays; }
+    uint32_t get_last_start_us() const { return last_start_us; }
+    static const char* sound_name(Sound sound);
+};
+
+#endif  // AUDIO_OUTPUT_H
@@ -0,0 +1,182 @@
+#include "bench.h"
+#include "ws2812_controller.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+#include "color_blend.h"
+#include "hot_path.h"
+
+// SysTick value captured by the handler; counts down, 24 bits
+static volatile uint32_t irq_entry_tick = 0;
+static volatile bool irq_fired = false;
+
+Benchmark& Benchmark::instance() {
+    static Benchmark bench;
+    if (!bench.initialized) {
+        bench.initialized = true;
+        bench.init();
+    }
+    return bench;
+}
+
+void Benchmark::init() {
+    // Free-running at clk_sys
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+    
+    // A spare IRQ that only software raises; the exclusive handler sits
+    // directly in the vector table, like the SDK's GPIO and timer handlers
+    user_irq = user_irq_claim_unused(true);
+    irq_set_exclusive_handler(user_irq, irq_handler);
+    irq_set_enabled(user_irq, true);
+}
+
+const char* Benchmark::profile_name() {
+#if FEUD_PERF_BUILD
+    return "perf";
+#else
+    return "size";
+#endif
+}
+
+void Benchmark::flush_xip_cache() {
+    // The read stalls until the flush has completed
+    xip_ctrl_hw->flush = 1;
+    (void)xip_ctrl_hw->flush;
+}
+
+uint32_t Benchmark::read_systick() {
+    return systick_hw->cvr;
+}
+
+void __isr HOT_PATH_FUNC(Benchmark::irq_handler)() {
+    irq_entry_tick = systick_hw->cvr;
+    irq_fired = true;
+}
+
+uint32_t Benchmark::measure_isr(bool cold) {
+    irq_fired = false;
+    if (cold) {
+        flush_xip_cache();
+    }
+    
+    const uint32_t start = read_systick();
+    irq_set_pending(user_irq);
+    while (!irq_fired) {
+        if (((start - read_systick()) & SYSTICK_MASK) > IRQ_TIMEOUT_CYCLES) break;
+    }
+    return (start - irq_entry_tick) & SYSTICK_MASK;
+}
+
+uint32_t Benchmark::measure_frame(bool cold) {
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    if (cold) {
+        flush_xip_cache();
+    }
+    
+    const uint32_t start = read_systick();
+    ws2812.render(true);
+    return (start - read_systick()) & SYSTICK_MASK;
+}
+
+// The float lerp set_gradient used before ColorBlender, kept as the baseline
+static void float_gradient(RGB* pixels, uint count, const RGB& start_color, const RGB& end_color) {
+    for (uint i = 0; i < count; i++) {
+        float ratio = (float)i / (float)(count - 1);
+        pixels[i] = RGB(
+            start_color.r + (end_color.r - start_color.r) * ratio,
+            start_color.g + (end_color.g - start_color.g) * ratio,
+            start_color.b + (end_color.b - start_color.b) * ratio
+        );
+    }
+}
+
+uint32_t Benchmark::measure_gradient(bool interp) {
+    static std::array<RGB, LEDS_PER_STRIP> pixels;
+    static constexpr RGB from(255, 96, 0);
+    static constexpr RGB to(16, 0, 200);
+    const ColorBlender& blender = ColorBlender::instance();
+    
+    const uint32_t start = read_systick();
+    if (interp) {
+        blender.gradient(pixels.data(), pixels.size(), from, to);
+    } else {
+        float_gradient(pixels.data(), pixels.size(), from, to);
+    }
+    return (start - read_systick()) & SYSTICK_MASK;
+}
+
+BenchStats Benchmark::summarize(const uint32_t* cycles, uint count) {
+    BenchStats stats;
+    if (count == 0) return stats;
+    
+    const uint64_t hz = clock_get_hz(clk_sys);
+    uint64_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint32_t min_cycles = UINT32_MAX;
+    uint32_t max_cycles = 0;
+    for (uint i = 0; i < count; i++) {
+        sum += cycles[i];
+        sum_sq += (uint64_t)cycles[i] * cycles[i];
+        min_cycles = std::min(min_cycles, cycles[i]);
+        max_cycles = std::max(max_cycles, cycles[i]);
+    }
+    
+    const double mean = (double)sum / count;
+    const double variance = std::max(0.0, (double)sum_sq / count - mean * mean);
+    const double ns_per_cycle = 1e9 / hz;
+    
+    stats.min_ns = min_cycles * ns_per_cycle;
+    stats.max_ns = max_cycles * ns_per_cycle;
+    stats.mean_ns = mean * ns_per_cycle;
+    stats.stddev_ns = std::sqrt(variance) * ns_per_cycle;
+    return stats;
+}
+
+BenchResult Benchmark::run(uint samples) {
+    static std::array<uint32_t, MAX_SAMPLES> cycles;
+    samples = std::clamp<uint>(samples, 1, MAX_SAMPLES);
+    
+    BenchResult result;
+    result.samples = samples;
+    
+    // Warm samples follow an untimed run that fills the cache
+    measure_isr(false);
+    for (uint i = 0; i < samples; i++) cycles[i] = measure_isr(false);
+    result.isr_warm = summarize(cycles.data(), samples);
+    
+    for (uint i = 0; i < samples; i++) cycles[i] = measure_isr(true);
+    result.isr_cold = summarize(cycles.data(), samples);
+    
+    // The first render may wait for a frame still on the wire
+    measure_frame(false);
+    for (uint i = 0; i < samples; i++) cycles[i] = measure_frame(false);
+    result.frame_warm = summarize(cycles.data(), samples);
+    watchdog_update();
+    
+    for (uint i = 0; i < samples; i++) cycles[i] = measure_frame(true);
+    result.frame_cold = summarize(cycles.data(), samples);
+    
+    // Cold frames at full sample count run for a good part of the watchdog
+    // timeout, so feed it here as well as in the main loop
+    watchdog_update();
+    
+    measure_gradient(false);
+    for (uint i = 0; i < samples; i++) cycles[i] = measure_gradient(false);
+    result.gradient_float = summarize(cycles.data(), samples);
+    
+    measure_gradient(true);
+    for (uint i = 0; i < samples; i++) cycles[i] = measure_gradient(true);
+    result.gradient_interp = summarize(cycles.data(), samples);
+    
+    return result;
+}
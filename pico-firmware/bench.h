@@ -0,0 +1,61 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+// Distribution of one measurement, in nanoseconds
+struct BenchStats {
+    uint32_t min_ns = 0;
+    uint32_t max_ns = 0;
+    uint32_t mean_ns = 0;
+    uint32_t stddev_ns = 0;
+};
+
+struct BenchResult {
+    uint32_t samples = 0;
+    BenchStats isr_warm;     // IRQ pending to first handler instruction
+    BenchStats isr_cold;     // Same, with the XIP cache flushed first
+    BenchStats frame_warm;   // Full render of one frame
+    BenchStats frame_cold;   // Same, with the XIP cache flushed first
+    BenchStats gradient_float;   // One strip's gradient, per-LED float lerp
+    BenchStats gradient_interp;  // Same gradient on the interpolator (ColorBlender)
+};
+
+// On-target benchmark for the performance build profile. Cold samples
+// flush the XIP cache first, as USB traffic and flash writes do in
+// practice; code left in flash then pays for refills, code in RAM does
+// not. Timing uses SysTick at clk_sys for cycle resolution. Run it on the
+// size and performance builds to compare.
+class Benchmark {
+ private:
+    bool initialized = false;
+    int user_irq = -1;
+    
+    static constexpr uint32_t SYSTICK_MASK = 0x00FFFFFF;
+    static constexpr uint32_t IRQ_TIMEOUT_CYCLES = 1000000;
+    
+    void init();
+    static void flush_xip_cache();
+    static uint32_t read_systick();
+    static void irq_handler();
+    uint32_t measure_isr(bool cold);
+    uint32_t measure_frame(bool cold);
+    uint32_t measure_gradient(bool interp);
+    static BenchStats summarize(const uint32_t* cycles, uint count);
+
+ public:
+    static constexpr uint MAX_SAMPLES = 256;
+    static constexpr uint DEFAULT_SAMPLES = 64;
+    
+    static Benchmark& instance();
+    
+    BenchResult run(uint samples);
+    
+    // Build profile this firmware was compiled with
+    static const char* profile_name();
+};
+
+#endif  // BENCH_H
@@ -0,0 +1,182 @@
+#include "clock_governor.h"
+
+#include <algorithm>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/vreg.h"
+
+static constexpr uint32_t LEVEL_KHZ[(size_t)ClockLevel::COUNT] = {
+    48000,   // IDLE
+    125000,  // NORMAL
+    200000   // BOOST
+};
+
+// clk_peri follows the USB PLL rather than clk_sys
+static constexpr uint32_t PERI_CLK_HZ = 48000000;
+
+// Settling time after raising the core voltage for BOOST
+static constexpr uint32_t VREG_SETTLE_US = 1000;
+
+// How often the load window is evaluated
+static constexpr uint32_t WINDOW_MS = 250;
+
+// Longest an in-flight LED frame may take to drain before a switch
+static constexpr uint32_t DMA_DRAIN_TIMEOUT_US = 5000;
+
+ClockGovernor& ClockGovernor::instance() {
+    static ClockGovernor governor;
+    if (!governor.initialized) {
+        governor.initialized = true;
+        governor.init();
+    }
+    return governor;
+}
+
+void ClockGovernor::init() {
+    // Derive the starting level from whatever the runtime configured
+    const uint32_t khz = clock_get_hz(clk_sys) / 1000;
+    level = ClockLevel::IDLE;
+    for (size_t i = 0; i < (size_t)ClockLevel::COUNT; i++) {
+        if (khz >= LEVEL_KHZ[i]) {
+            level = (ClockLevel)i;
+        }
+    }
+    
+    const uint32_t now = to_ms_since_boot(get_absolute_time());
+    window_start_ms = now;
+    low_load_since_ms = now;
+    level_entered_ms = now;
+}
+
+void ClockGovernor::add_listener(ClockListener listener) {
+    if (listener_count < MAX_LISTENERS) {
+        listeners[listener_count++] = listener;
+    }
+}
+
+void ClockGovernor::report_render(uint32_t render_us, uint32_t period_us) {
+    window_render_us = std::max(window_render_us, render_us);
+    window_period_us = period_us;
+}
+
+void ClockGovernor::update(bool round_active) {
+    const uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (now - window_start_ms < WINDOW_MS) return;
+    
+    const uint32_t load = window_period_us ? (window_render_us * 100) / window_period_us : 0;
+    window_start_ms = now;
+    window_render_us = 0;
+    
+    if (!automatic) return;
+    
+    ClockLevel target = level;
+    if (load >= BOOST_LOAD_PERCENT) {
+        if (level < ClockLevel::BOOST) {
+            target = (ClockLevel)((size_t)level + 1);
+        }
+        low_load_since_ms = now;
+    } else if (load < RELAX_LOAD_PERCENT) {
+        if (level > ClockLevel::IDLE && now - low_load_since_ms >= RELAX_HOLD_MS) {
+            // Only step down if the same work still fits at the lower clock
+            const ClockLevel lower = (ClockLevel)((size_t)level - 1);
+            const uint32_t projected = load * level_khz(level) / level_khz(lower);
+            if (projected < BOOST_LOAD_PERCENT) {
+                target = lower;
+            }
+            low_load_since_ms = now;
+        }
+    } else {
+        low_load_since_ms = now;
+    }
+    
+    // Never sit at the idle clock while a round is in progress
+    if (round_active && target < ClockLevel::NORMAL) {
+        target = ClockLevel::NORMAL;
+    }
+    
+    if (target != level) {
+        apply(target);
+    }
+}
+
+bool ClockGovernor::set_level(ClockLevel new_level) {
+    automatic = false;
+    return apply(new_level);
+}
+
+bool ClockGovernor::apply(ClockLevel new_level) {
+    if (new_level == level) return true;
+    
+    const uint32_t khz = level_khz(new_level);
+    uint vco_freq, post_div1, post_div2;
+    if (!check_sys_clock_khz(khz, &vco_freq, &post_div1, &post_div2)) {
+        return false;
+    }
+    
+    const uint32_t start = time_us_32();
+    
+    // Raise the core voltage before the clock, lower it after
+    if (new_level == ClockLevel::BOOST) {
+        vreg_set_voltage(VREG_VOLTAGE_1_15);
+        busy_wait_us_32(VREG_SETTLE_US);
+    }
+    
+    // Let in-flight DMA (LED frames) drain so no transfer straddles the switch
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (drain_exempt_mask & (1u << channel)) continue;
+        while (dma_channel_is_claimed(channel) && dma_channel_is_busy(channel) &&
+               time_us_32() - start < DMA_DRAIN_TIMEOUT_US) {
+            tight_loop_contents();
+        }
+    }
+    
+    // Switch and re-derive every dependent divider before any IRQ can run
+    uint32_t irq_state = save_and_disable_interrupts();
+    set_sys_clock_pll(vco_freq, post_div1, post_div2);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, PERI_CLK_HZ, PERI_CLK_HZ);
+    const uint32_t sys_hz = clock_get_hz(clk_sys);
+    for (size_t i = 0; i < listener_count; i++) {
+        listeners[i](sys_hz);
+    }
+    restore_interrupts(irq_state);
+    
+    if (new_level != ClockLevel::BOOST) {
+        vreg_set_voltage(VREG_VOLTAGE_DEFAULT);
+    }
+    
+    const uint32_t now = to_ms_since_boot(get_absolute_time());
+    level_time_ms[(size_t)level] += now - level_entered_ms;
+    level_entered_ms = now;
+    level = new_level;
+    switches++;
+    last_switch_us = time_us_32() - start;
+    return true;
+}
+
+uint32_t ClockGovernor::get_sys_hz() const {
+    return clock_get_hz(clk_sys);
+}
+
+uint32_t ClockGovernor::get_level_time_ms(ClockLevel l) const {
+    uint32_t total = level_time_ms[(size_t)l];
+    if (l == level) {
+        total += to_ms_since_boot(get_absolute_time()) - level_entered_ms;
+    }
+    return total;
+}
+
+uint32_t ClockGovernor::level_khz(ClockLevel l) {
+    return LEVEL_KHZ[(size_t)l];
+}
+
+const char* ClockGovernor::level_name(ClockLevel l) {
+    switch (l) {
+        case ClockLevel::IDLE: return "idle";
+        case ClockLevel::NORMAL: return "normal";
+        case ClockLevel::BOOST: return "boost";
+        default: return "?";
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef CLOCK_GOVERNOR_H
+#define CLOCK_GOVERNOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "pico/stdlib.h"
+
+enum class ClockLevel {
+    IDLE,
+    NORMAL,
+    BOOST,
+    COUNT
+};
+
+// Callback run after clk_sys changes, with interrupts disabled and the
+// LED DMA idle. Used to re-derive PIO clock dividers and DMA pacing.
+using ClockListener = void (*)(uint32_t sys_hz);
+
+// Scales clk_sys with render load. Each frame's render time is compared
+// against the frame period; sustained high load steps the clock up, a
+// long stretch of low load steps it back down. clk_peri is pinned to the
+// 48MHz USB PLL and the frame timer runs from clk_ref, so USB, the
+// scheduler and the watchdog are unaffected by a switch.
+class ClockGovernor {
+ private:
+    bool initialized = false;
+    ClockLevel level = ClockLevel::NORMAL;
+    bool automatic = true;
+    
+    static constexpr size_t MAX_LISTENERS = 4;
+    std::array<ClockListener, MAX_LISTENERS> listeners{};
+    size_t listener_count = 0;
+    
+    // Streaming DMA channels a switch does not wait for
+    uint32_t drain_exempt_mask = 0;
+    
+    // Load thresholds, in percent of the frame period spent rendering
+    static constexpr uint32_t BOOST_LOAD_PERCENT = 50;
+    static constexpr uint32_t RELAX_LOAD_PERCENT = 20;
+    static constexpr uint32_t RELAX_HOLD_MS = 2000;
+    
+    // Worst render time seen since the last decision
+    uint32_t window_render_us = 0;
+    uint32_t window_period_us = 0;
+    uint32_t window_start_ms = 0;
+    uint32_t low_load_since_ms = 0;
+    
+    // Statistics
+    uint32_t switches = 0;
+    uint32_t last_switch_us = 0;
+    std::array<uint32_t, (size_t)ClockLevel::COUNT> level_time_ms{};
+    uint32_t level_entered_ms = 0;
+    
+    void init();
+    bool apply(ClockLevel new_level);
+
+ public:
+    static ClockGovernor& instance();
+    
+    void add_listener(ClockListener listener);
+    
+    // For endless channels paced by a timer, whose listener re-derives the pacing
+    void exempt_from_drain(uint dma_channel, bool exempt = true) {
+        drain_exempt_mask = exempt ? (drain_exempt_mask | (1u << dma_channel)) : (drain_exempt_mask & ~(1u << dma_channel));
+    }
+    
+    // Reports the render time of a frame and the frame period it had to fit in
+    void report_render(uint32_t render_us, uint32_t period_us);
+    
+    // Evaluates the load window; round_active keeps the clock at NORMAL or
+    // above so button handling never runs at the idle clock mid-round
+    void update(bool round_active);
+    
+    // Pins the clock to a level; set_automatic(true) hands control back
+    bool set_level(ClockLevel new_level);
+    void set_automatic(bool enable) { automatic = enable; }
+    bool is_automatic() const { return automatic; }
+    
+    ClockLevel get_level() const { return level; }
+    uint32_t get_sys_hz() const;
+    uint32_t get_switches() const { return switches; }
+    uint32_t get_last_switch_us() const { return last_switch_us; }
+    uint32_t get_level_time_ms(ClockLevel l) const;
+    static uint32_t level_khz(ClockLevel l);
+    static const char* level_name(ClockLevel l);
+};
+
+#endif  // CLOCK_GOVERNOR_H
@@ -0,0 +1,36 @@
+#include "color_blend.h"
+
+#include "hot_path.h"
+
+ColorBlender& ColorBlender::instance() {
+    static ColorBlender blender;
+    if (!blender.initialized) {
+        blender.initialized = true;
+        blender.init();
+    }
+    return blender;
+}
+
+void ColorBlender::init() {
+#if PICO_ON_DEVICE
+    // Lane 0 in blend mode; lane 1 passes ACCUM1 through as the alpha and
+    // is signed, so a falling channel (to < from) blends correctly
+    interp_config lane0 = interp_default_config();
+    interp_config_set_blend(&lane0, true);
+    interp_set_config(interp0, 0, &lane0);
+    
+    interp_config lane1 = interp_default_config();
+    interp_config_set_signed(&lane1, true);
+    interp_set_config(interp0, 1, &lane1);
+#endif
+}
+
+void HOT_PATH_FUNC(ColorBlender::gradient)(RGB* pixels, uint count, const RGB& from, const RGB& to) const {
+    if (count == 0) return;
+    
+    const uint32_t step = ramp_step(count);
+    for (uint i = 0; i + 1 < count; i++) {
+        pixels[i] = blend(from, to, ramp_alpha(i, step));
+    }
+    pixels[count - 1] = count > 1 ? to : from;
+}
@@ -0,0 +1,57 @@
+#ifndef COLOR_BLEND_H
+#define COLOR_BLEND_H
+
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "ws2812_controller.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/interp.h"
+#endif
+
+// Linear color blends on core 0's interp0 in blend mode: lane 1 holds
+// the 8-bit alpha and each channel costs one BASE01 write and one read,
+// instead of a float lerp. Only the main loop may use it, so its
+// configuration is set once and never saved: no interrupt handler
+// renders (the button IRQ leaves the strips to Feud::announce_presses()),
+// and a new one that does must interp_save()/interp_restore() around it.
+// The host build computes the same integer blend in software.
+class ColorBlender {
+ private:
+    bool initialized = false;
+    
+    void init();
+
+ public:
+    static constexpr uint ALPHA_ONE = 256;
+    
+    static ColorBlender& instance();
+    
+    // from + (to - from) * alpha / 256; alpha 256 gives exactly to
+    RGB blend(const RGB& from, const RGB& to, uint alpha) const {
+        if (alpha >= ALPHA_ONE) return to;
+#if PICO_ON_DEVICE
+        interp0->accum[1] = alpha;
+        const auto channel = [](uint8_t a, uint8_t b) -> uint8_t {
+            interp0->base01 = a | ((uint32_t)b << 16);
+            return interp0->peek[1];
+        };
+#else
+        const auto channel = [alpha](uint8_t a, uint8_t b) -> uint8_t {
+            return a + ((((int32_t)b - a) * (int32_t)alpha) >> 8);
+        };
+#endif
+        return RGB(channel(from.r, to.r), channel(from.g, to.g), channel(from.b, to.b));
+    }
+    
+    // Alpha per pixel of a count-pixel ramp, 16.16; pixel i of the ramp
+    // is blend(from, to, ramp_alpha(i, step))
+    static uint32_t ramp_step(uint count) { return count > 1 ? (ALPHA_ONE << 16) / (count - 1) : 0; }
+    static uint ramp_alpha(uint index, uint32_t step) { return (index * step + 0x8000) >> 16; }
+    
+    // count pixels from `from` to `to`, both end points exact
+    void gradient(RGB* pixels, uint count, const RGB& from, const RGB& to) const;
+};
+
+#endif  // COLOR_BLEND_H
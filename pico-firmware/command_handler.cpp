@@ -2,15 +2,33 @@
 #include "usb_serial.h"
 #include "feud.h"
 #include "ws2812_controller.h"
+#include "frame_scheduler.h"
+#include "config_store.h"
+#include "system_monitor.h"
+#include "clock_governor.h"
+#include "pio_manager.h"
+#include "bench.h"
+#include "effect_vm.h"
+#include "audio_output.h"
+#include "player_lamps.h"
+#include "data_port.h"
 #include <cstring>
 #include <cctype>
 #include <algorithm>
 #include <ranges>
 #include <bit>
-#include <cstdio>
 
 using namespace std::literals;
 
+static constexpr std::array<std::pair<std::string_view, AnimationMode>, 6> animation_modes{{
+    {"static", AnimationMode::STATIC},
+    {"fade", AnimationMode::FADE},
+    {"rainbow", AnimationMode::RAINBOW},
+    {"chase", AnimationMode::CHASE},
+    {"pulse", AnimationMode::PULSE},
+    {"sparkle", AnimationMode::SPARKLE}
+}};
+
 CommandHandler& CommandHandler::instance() {
     static CommandHandler handler;
     if (!handler.initialized) {
@@ -74,45 +92,86 @@ void CommandHandler::cmd_hello(std::string_view args) {
 void CommandHandler::cmd_status([[maybe_unused]] std::string_view args) {
     USBSerial& serial = USBSerial::instance();
     Feud& feud = Feud::instance();
-    
-    char status_msg[256];
-    const char* state_str;
-    
-    switch (feud.get_state()) {
+    SystemMonitor& monitor = SystemMonitor::instance();
+    
+    // One consistent copy; a press landing while this prints shows up next time
+    const FeudSnapshot game = feud.snapshot();
+    char order[3 * MAX_PLAYERS + 1];
+    game.format_press_order(order, sizeof(order));
+    
+    serial.append("System Status: OK\n"
+                  "USB Serial: Connected\n"
+                  "Boot To Ready: ", monitor.get_boot_to_ready_us(), " us\n"
+                  "Game State: ");
+    switch (game.state) {
         case GameState::IDLE:
-            state_str = "idle";
+            serial.append("idle");
             break;
         case GameState::TIMER_RUNNING:
-            state_str = "timer_running";
+            serial.append("timer_running");
             break;
         case GameState::TIMER_PAUSED:
-            state_str = "timer_paused";
-            break;
-        case GameState::PLAYER_A_PRESSED:
-            state_str = "player_a_pressed";
+            serial.append("timer_paused");
             break;
-        case GameState::PLAYER_B_PRESSED:
-            state_str = "player_b_pressed";
+        case GameState::PLAYER_PRESSED:
+            serial.append("player_", (char)std::tolower(game.active_player()), "_pressed");
             break;
         default:
-            state_str = "unknown";
+            serial.append("unknown");
     }
+    serial.append("\nTimer: ", game.time_remaining, " seconds\n");
     
-    snprintf(status_msg, sizeof(status_msg),
-             "System Status: OK\n"
-             "USB Serial: Connected\n"
-             "Game State: %s\n"
-             "Timer: %lu seconds\n"
-             "Player A: %s\n"
-             "Player B: %s\n"
-             "Active Player: %c\n",
-             state_str,
-             feud.get_time_remaining(),
-             feud.is_player_a_pressed() ? "PRESSED" : "Ready",
-             feud.is_player_b_pressed() ? "PRESSED" : "Ready",
-             feud.get_active_player());
+    for (uint i = 0; i < game.player_count; i++) {
+        serial.append("Player ", player_letter(i), ": ", game.is_player_pressed(i) ? "PRESSED" : "Ready", '\n');
+    }
     
-    serial.send_data(reinterpret_cast<const uint8_t*>(status_msg), strlen(status_msg));
+    serial.append("Active Player: ", game.active_player(), game.is_tie() ? " (tie)" : "", "\n"
+                  "Press Order: ", order, "\n");
+    
+    serial.append("Reset Reason: ", SystemMonitor::reset_reason_name(monitor.get_reset_reason()), "\n"
+                  "Loop Overruns: ", monitor.get_overruns(),
+                  " (budget ", monitor.get_loop_budget_us(), " us, worst ", monitor.get_worst_iteration_us(), " us)\n"
+                  "Overruns By Phase: game=", monitor.get_phase_overruns(LoopPhase::GAME),
+                  " leds=", monitor.get_phase_overruns(LoopPhase::LEDS),
+                  " config=", monitor.get_phase_overruns(LoopPhase::CONFIG),
+                  " usb=", monitor.get_phase_overruns(LoopPhase::USB), "\n"
+                  "Last Overrun: ",
+                  monitor.get_overruns() ? SystemMonitor::phase_name(monitor.get_last_overrun_phase()) : "none",
+                  ' ', monitor.get_last_overrun_us(), " us\n"
+                  "Status Emit: ", feud.get_status_emit_us(), " us\n");
+    serial.flush();
+}
+
+void CommandHandler::cmd_players(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    Feud& feud = Feud::instance();
+    
+    if (!args.empty()) {
+        // Parse: button led [button led ...]
+        uint32_t values[2 * MAX_PLAYERS] = {};
+        size_t parsed = parse_numbers(args, values, 2 * MAX_PLAYERS);
+        
+        std::array<PlayerConfig, MAX_PLAYERS> configs{};
+        for (size_t i = 0; i < parsed / 2; i++) {
+            configs[i] = PlayerConfig{values[2 * i], values[2 * i + 1]};
+        }
+        
+        if (parsed == 0 || parsed % 2 != 0 || feud.get_state() != GameState::IDLE ||
+            !feud.configure_players(configs.data(), parsed / 2)) {
+            constexpr std::string_view error_msg = "Error: players requires idle game and 1-8 distinct pairs: button led, off the strip and audio pins, lamps on at most 4 PWM slices\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+    }
+    
+    for (uint i = 0; i < feud.get_player_count(); i++) {
+        const PlayerConfig& config = feud.get_player_config(i);
+        serial.append("Player ", player_letter(i), ": button=", config.button_pin, " led=", config.led_pin, '\n');
+    }
+    const PlayerLamps& lamps = PlayerLamps::instance();
+    serial.append("Lamps: slices=", lamps.get_slice_count(), " tick_slice=", lamps.get_tick_slice(),
+                  " period=", lamps.get_period_ms(), "ms changes=", lamps.get_pattern_changes(), '\n');
+    serial.flush();
 }
 
 void CommandHandler::cmd_help([[maybe_unused]] std::string_view args) {
@@ -122,18 +181,48 @@ void CommandHandler::cmd_help([[maybe_unused]] std::string_view args) {
         std::string_view{"Available commands:\n"},
         std::string_view{"  hello [name]       - Say hello\n"},
         std::string_view{"  status             - Get system status\n"},
-        std::string_view{"  start_timer <sec>  - Start game timer\n"},
+        std::string_view{"  start_timer [sec]  - Start game timer\n"},
+        std::string_view{"  timer_default <sec> - Default start_timer duration\n"},
         std::string_view{"  stop_timer         - Stop game timer\n"},
         std::string_view{"  pause_timer        - Pause running timer\n"},
         std::string_view{"  resume_timer       - Resume paused timer\n"},
         std::string_view{"  reset_game         - Reset game state\n"},
         std::string_view{"  force_reset        - Complete system reset\n"},
+        std::string_view{"  players [<button> <led> ...]       - Show or set player pins\n"},
         std::string_view{"  led_set <strip> <led> <r> <g> <b> - Set single LED\n"},
         std::string_view{"  led_strip <strip> <r> <g> <b>     - Set entire strip\n"},
         std::string_view{"  led_all <r> <g> <b>                - Set all LEDs\n"},
         std::string_view{"  led_clear [strip]                  - Clear LEDs\n"},
         std::string_view{"  led_animate <mode> [speed]         - Set animation\n"},
         std::string_view{"  led_brightness <0-100>             - Set brightness\n"},
+        std::string_view{"  led_dither <on|off>                - High-refresh temporal dithering\n"},
+        std::string_view{"  led_driver [<strip> <ws2812|sk6812|apa102>] - Show or set strip chips\n"},
+        std::string_view{"  frame_rate <hz>                    - Set LED frame rate\n"},
+        std::string_view{"  frame_stats [reset]                - Frame timing statistics\n"},
+        std::string_view{"  clock [auto|idle|normal|boost]     - Show or pin the system clock\n"},
+        std::string_view{"  pio_stats                          - PIO and DMA utilization\n"},
+        std::string_view{"  usbstats [reset]                   - USB link counters and host health\n"},
+        std::string_view{"  time_sync <token>                  - Clock sync probe: device rx/tx time in us\n"},
+        std::string_view{"  bench [samples]                    - ISR latency, frame and gradient cost, warm/cold cache\n"},
+        std::string_view{"  layer_animate <layer> <mode> [speed]  - Animate a layer\n"},
+        std::string_view{"  layer_color <layer> <r> <g> <b> [<r> <g> <b>] - Layer colors\n"},
+        std::string_view{"  layer_blend <layer> <normal|add|multiply|max> [opacity] - Blend mode\n"},
+        std::string_view{"  layer_mask <layer> <strips> [start count] - Strip bitmask and range\n"},
+        std::string_view{"  layer_off <layer>                  - Disable a layer\n"},
+        std::string_view{"  zone_define <name> <strip> <start> <count> [...] - Define a zone from up to 4 ranges\n"},
+        std::string_view{"  zone_delete <name>                 - Remove a zone\n"},
+        std::string_view{"  zone_fill <name> <r> <g> <b> [offset count] - Fill a zone or part of it\n"},
+        std::string_view{"  zone_gradient <name> <r> <g> <b> <r> <g> <b> [offset count] - Zone gradient\n"},
+        std::string_view{"  zone_animate <name> <mode> [speed] [<r> <g> <b> [<r> <g> <b>]] - Animate a zone\n"},
+        std::string_view{"  zones                              - List zones\n"},
+        std::string_view{"  effect_begin                       - Start uploading an effect program\n"},
+        std::string_view{"  effect_data <hex>                  - Append program bytes\n"},
+        std::string_view{"  effect_commit <slot>               - Validate and load the upload into a slot\n"},
+        std::string_view{"  effects                            - List effect slots\n"},
+        std::string_view{"  layer_effect <layer> <slot>        - Run an effect program on a layer\n"},
+        std::string_view{"  audio [on|off|buzzer|expired|volume <0-255>] - On-device sound\n"},
+        std::string_view{"  save               - Save settings to flash\n"},
+        std::string_view{"  config [clear]     - Show or erase saved settings\n"},
         std::string_view{"  help               - Show this help\n"}
     };
     
@@ -146,14 +235,14 @@ void CommandHandler::cmd_start_timer(std::string_view args) {
     USBSerial& serial = USBSerial::instance();
     Feud& feud = Feud::instance();
     
-    if (args.empty()) {
+    if (args.empty() && feud.get_default_duration() == 0) {
         constexpr std::string_view error_msg = "Error: start_timer requires duration in seconds\n";
         serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
         return;
     }
     
-    // Parse duration from args
-    uint32_t duration = 0;
+    // Parse duration from args, falling back to the configured default
+    uint32_t duration = args.empty() ? feud.get_default_duration() : 0;
     for (char c : args) {
         if (c >= '0' && c <= '9') {
             duration = duration * 10 + (c - '0');
@@ -166,7 +255,7 @@ void CommandHandler::cmd_start_timer(std::string_view args) {
         }
     }
     
-    if (duration == 0 || duration > 300) {
+    if (duration == 0 || duration > MAX_TIMER_SECONDS) {
         constexpr std::string_view error_msg = "Error: Duration must be between 1 and 300 seconds\n";
         serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
         return;
@@ -174,9 +263,7 @@ void CommandHandler::cmd_start_timer(std::string_view args) {
     
     feud.start_timer(duration);
     
-    char response[64];
-    snprintf(response, sizeof(response), "Timer started for %lu seconds\n", duration);
-    serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+    serial.print("Timer started for ", duration, " seconds\n");
 }
 
 void CommandHandler::cmd_stop_timer([[maybe_unused]] std::string_view args) {
@@ -249,6 +336,47 @@ std::string_view CommandHandler::trim_whitespace(std::string_view str) const noe
     return str.substr(start, end - start + 1);
 }
 
+size_t CommandHandler::parse_numbers(std::string_view args, uint32_t* values, size_t max_values) noexcept {
+    size_t parsed = 0;
+    const char* ptr = args.data();
+    const char* end = ptr + args.size();
+    
+    while (parsed < max_values && ptr < end) {
+        while (ptr < end && (*ptr == ' ' || *ptr == '\t')) ptr++;
+        if (ptr >= end) break;
+        
+        uint32_t val = 0;
+        bool found_digit = false;
+        while (ptr < end && *ptr >= '0' && *ptr <= '9') {
+            val = val * 10 + (*ptr - '0');
+            ptr++;
+            found_digit = true;
+        }
+        
+        if (!found_digit) break;
+        values[parsed++] = val;
+    }
+    
+    return parsed;
+}
+
+std::string_view CommandHandler::take_word(std::string_view& args) noexcept {
+    const auto space_pos = std::min(args.find(' '), args.size());
+    std::string_view word = args.substr(0, space_pos);
+    args = args.substr(space_pos);
+    args = args.substr(std::min(args.find_first_not_of(" \t"), args.size()));
+    return word;
+}
+
+std::optional<AnimationMode> CommandHandler::parse_animation_mode(std::string_view name) noexcept {
+    for (const auto& [mode_name, mode] : animation_modes) {
+        if (str_equal_case_insensitive(mode_name, name)) {
+            return mode;
+        }
+    }
+    return std::nullopt;
+}
+
 std::optional<std::pair<std::string_view, std::string_view>> 
 CommandHandler::parse_command_line(std::string_view line) const noexcept {
     line = trim_whitespace(line);
@@ -323,10 +451,7 @@ void CommandHandler::cmd_led_set(std::string_view args) {
     ws2812.set_led(strip, led, r, g, b);
     ws2812.set_animation(AnimationMode::STATIC);
     
-    char response[64];
-    snprintf(response, sizeof(response), "LED set: strip %lu, led %lu = (%lu,%lu,%lu)\n", 
-             strip, led, r, g, b);
-    serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+    serial.print("LED set: strip ", strip, ", led ", led, " = (", r, ',', g, ',', b, ")\n");
 }
 
 void CommandHandler::cmd_led_strip(std::string_view args) {
@@ -380,9 +505,7 @@ void CommandHandler::cmd_led_strip(std::string_view args) {
     ws2812.set_strip(strip, RGB(r, g, b));
     ws2812.set_animation(AnimationMode::STATIC);
     
-    char response[64];
-    snprintf(response, sizeof(response), "Strip %lu set to (%lu,%lu,%lu)\n", strip, r, g, b);
-    serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+    serial.print("Strip ", strip, " set to (", r, ',', g, ',', b, ")\n");
 }
 
 void CommandHandler::cmd_led_all(std::string_view args) {
@@ -430,9 +553,7 @@ void CommandHandler::cmd_led_all(std::string_view args) {
     ws2812.set_all(RGB(r, g, b));
     ws2812.set_animation(AnimationMode::STATIC);
     
-    char response[64];
-    snprintf(response, sizeof(response), "All LEDs set to (%lu,%lu,%lu)\n", r, g, b);
-    serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+    serial.print("All LEDs set to (", r, ',', g, ',', b, ")\n");
 }
 
 void CommandHandler::cmd_led_clear(std::string_view args) {
@@ -465,9 +586,7 @@ void CommandHandler::cmd_led_clear(std::string_view args) {
         ws2812.clear_strip(strip);
         ws2812.set_animation(AnimationMode::STATIC);
         
-        char response[64];
-        snprintf(response, sizeof(response), "Strip %lu cleared\n", strip);
-        serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+        serial.print("Strip ", strip, " cleared\n");
     }
 }
 
@@ -481,24 +600,13 @@ void CommandHandler::cmd_led_animate(std::string_view args) {
         ? args.substr(0, space_pos) 
         : args;
     
-    AnimationMode mode = AnimationMode::STATIC;
-    if (str_equal_case_insensitive(mode_str, "static")) {
-        mode = AnimationMode::STATIC;
-    } else if (str_equal_case_insensitive(mode_str, "fade")) {
-        mode = AnimationMode::FADE;
-    } else if (str_equal_case_insensitive(mode_str, "rainbow")) {
-        mode = AnimationMode::RAINBOW;
-    } else if (str_equal_case_insensitive(mode_str, "chase")) {
-        mode = AnimationMode::CHASE;
-    } else if (str_equal_case_insensitive(mode_str, "pulse")) {
-        mode = AnimationMode::PULSE;
-    } else if (str_equal_case_insensitive(mode_str, "sparkle")) {
-        mode = AnimationMode::SPARKLE;
-    } else {
+    auto parsed_mode = parse_animation_mode(mode_str);
+    if (!parsed_mode) {
         constexpr std::string_view error_msg = "Error: Invalid animation mode. Use: static, fade, rainbow, chase, pulse, sparkle\n";
         serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
         return;
     }
+    AnimationMode mode = *parsed_mode;
     
     // Parse optional speed
     uint32_t speed = 100;  // Default speed
@@ -513,11 +621,9 @@ void CommandHandler::cmd_led_animate(std::string_view args) {
         }
     }
     
+    speed = std::clamp(speed, MIN_ANIMATION_SPEED_MS, MAX_ANIMATION_SPEED_MS);
     ws2812.set_animation(mode, speed);
-    char response[64];
-    snprintf(response, sizeof(response), "Animation set to %.*s (speed: %lums)\n", 
-             (int)mode_str.size(), mode_str.data(), speed);
-    serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+    serial.print("Animation set to ", mode_str, " (speed: ", speed, "ms)\n");
 }
 
 void CommandHandler::cmd_led_brightness(std::string_view args) {
@@ -552,7 +658,762 @@ void CommandHandler::cmd_led_brightness(std::string_view args) {
     
     ws2812.set_brightness(brightness / 100.0f);
     
-    char response[64];
-    snprintf(response, sizeof(response), "Brightness set to %lu%%\n", brightness);
-    serial.send_data(reinterpret_cast<const uint8_t*>(response), strlen(response));
+    serial.print("Brightness set to ", brightness, "%\n");
+}
+
+void CommandHandler::cmd_led_dither(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    bool enabled;
+    if (str_equal_case_insensitive(args, "on") || args == "1") {
+        enabled = true;
+    } else if (str_equal_case_insensitive(args, "off") || args == "0") {
+        enabled = false;
+    } else {
+        constexpr std::string_view error_msg = "Error: led_dither requires on or off\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    ws2812.set_dithering(enabled);
+    
+    serial.print("Dithering ", enabled ? "on" : "off", " (frame rate: ", FrameScheduler::instance().get_rate(), "Hz)\n");
+}
+
+void CommandHandler::cmd_led_driver(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    if (!args.empty()) {
+        // Parse: strip chip
+        uint32_t strip = 0;
+        LedChip chip = LedChip::COUNT;
+        if (parse_numbers(args, &strip, 1) == 1) {
+            std::string_view chip_name = args.substr(std::min(args.find(' '), args.size()));
+            chip_name = chip_name.substr(std::min(chip_name.find_first_not_of(" \t"), chip_name.size()));
+            for (uint i = 0; i < (uint)LedChip::COUNT; i++) {
+                if (str_equal_case_insensitive(chip_name, LedDriver::chip_name((LedChip)i))) {
+                    chip = (LedChip)i;
+                    break;
+                }
+            }
+        }
+        if (chip == LedChip::COUNT || strip >= NUM_STRIPS) {
+            constexpr std::string_view error_msg = "Error: Usage: led_driver <strip> <ws2812|sk6812|apa102>\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+        if (!ws2812.set_strip_chip(strip, chip)) {
+            serial.print("Error: Only ", MAX_WIDE_STRIPS, " strip(s) can run sk6812 or apa102 at once\n");
+            return;
+        }
+    }
+    
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        serial.append("Strip ", i, ": ", LedDriver::chip_name(ws2812.get_strip_chip(i)), '\n');
+    }
+    serial.print("Max frame rate: ", ws2812.get_max_frame_rate(), "Hz\n");
+}
+
+void CommandHandler::cmd_frame_rate(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    uint32_t rate = 0;
+    if (parse_numbers(args, &rate, 1) != 1 || rate < MIN_FRAME_RATE_HZ || rate > MAX_FRAME_RATE_HZ) {
+        serial.print("Error: Frame rate must be ", MIN_FRAME_RATE_HZ, '-', MAX_FRAME_RATE_HZ, " Hz\n");
+        return;
+    }
+    
+    ws2812.set_frame_rate(rate);
+    
+    serial.print("Frame rate set to ", rate, "Hz (running at ", FrameScheduler::instance().get_rate(), "Hz)\n");
+}
+
+void CommandHandler::cmd_frame_stats(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    FrameScheduler& scheduler = FrameScheduler::instance();
+    
+    FrameStats stats = scheduler.get_stats();
+    
+    serial.print("frame_stats: rate=", stats.rate_hz, " frames=", stats.frames, " missed=", stats.missed,
+                 " jitter_max=", stats.tick_jitter_max_us, "us latency_avg=", stats.latency_avg_us,
+                 "us latency_max=", stats.latency_max_us, "us\n");
+    
+    if (str_equal_case_insensitive(args, "reset")) {
+        scheduler.reset_stats();
+    }
+}
+
+void CommandHandler::cmd_usbstats(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    DataPort& data_port = DataPort::instance();
+    
+    // Copied first: printing this adds to the counters
+    const UsbStats stats = serial.get_stats();
+    
+    serial.append("usbstats: connected=", serial.is_connected(), " connects=", stats.connects,
+                  " command_gap_ms=", serial.get_line_gap_us() / 1000, '\n');
+    serial.append("  rx: bytes=", stats.rx_bytes, " lines=", stats.rx_lines, " truncated=", stats.rx_truncated, '\n');
+    serial.append("  tx: bytes=", stats.tx_bytes, " lines=", stats.tx_lines, " dropped=", stats.tx_dropped,
+                  " queue_max=", stats.tx_queue_max, '\n');
+    serial.append("  held: max=", stats.held_max, " dropped=", stats.held_dropped, '\n');
+    serial.append("  stalls: count=", stats.tx_stalls, " timeouts=", stats.tx_timeouts,
+                  " total=", stats.tx_stall_us, "us max=", stats.tx_stall_max_us, "us\n");
+    serial.print("  data: connected=", data_port.is_connected(), " packets=", data_port.get_packets_received(),
+                 " frames=", data_port.get_frames_received(), " bad=", data_port.get_bad_packets(),
+                 " telemetry=", data_port.get_telemetry_sent(), " dropped=", data_port.get_tx_dropped(), '\n');
+    
+    if (str_equal_case_insensitive(args, "reset")) {
+        serial.reset_stats();
+    }
+}
+
+void CommandHandler::cmd_clock(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    ClockGovernor& governor = ClockGovernor::instance();
+    
+    if (!args.empty()) {
+        if (str_equal_case_insensitive(args, "auto")) {
+            governor.set_automatic(true);
+        } else {
+            bool found = false;
+            for (size_t i = 0; i < (size_t)ClockLevel::COUNT; i++) {
+                if (str_equal_case_insensitive(args, ClockGovernor::level_name((ClockLevel)i))) {
+                    found = governor.set_level((ClockLevel)i);
+                    break;
+                }
+            }
+            if (!found) {
+                constexpr std::string_view error_msg = "Error: Usage: clock [auto|idle|normal|boost]\n";
+                serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+                return;
+            }
+        }
+    }
+    
+    serial.print("clock: level=", ClockGovernor::level_name(governor.get_level()),
+                 " sys=", governor.get_sys_hz(), "Hz auto=", governor.is_automatic(),
+                 " switches=", governor.get_switches(), " last_switch=", governor.get_last_switch_us(),
+                 "us idle=", governor.get_level_time_ms(ClockLevel::IDLE),
+                 "ms normal=", governor.get_level_time_ms(ClockLevel::NORMAL),
+                 "ms boost=", governor.get_level_time_ms(ClockLevel::BOOST), "ms\n");
+}
+
+void CommandHandler::cmd_pio_stats([[maybe_unused]] std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    
+    PioManager& pio_manager = PioManager::instance();
+    
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        const PioBlockInfo& block = pio_manager.get_block(i);
+        serial.append("pio", i, ": instr=", block.instructions_used, '/', PIO_INSTRUCTION_COUNT,
+                      " sm=", block.sms_used(), '/', NUM_PIO_STATE_MACHINES, " programs=");
+        for (size_t p = 0; p < block.program_count; p++) {
+            serial.append(p ? "," : "", block.programs[p].name, '@', block.programs[p].offset);
+        }
+        if (block.program_count == 0) {
+            serial.append('-');
+        }
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            if (block.sms[sm].owner) {
+                serial.append(" sm", sm, '=', block.sms[sm].owner);
+            }
+        }
+        serial.append('\n');
+    }
+    
+    serial.append("dma: channels=", pio_manager.get_dma_channels_used(), '/', NUM_DMA_CHANNELS);
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (const char* owner = pio_manager.get_dma_owner(channel)) {
+            serial.append(" ch", channel, '=', owner);
+        }
+    }
+    serial.print('\n');
+}
+
+void CommandHandler::cmd_time_sync(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    
+    // One NTP-style probe: the host timestamps its send and the reply
+    // arrival, the device reports when the request arrived and when the
+    // reply left, both on the time_us_64 timeline used by status t= fields
+    const uint64_t rx_us = serial.get_line_rx_us();
+    serial.print("time_sync: token=", args, " rx=", rx_us, " tx=", time_us_64(), '\n');
+}
+
+void CommandHandler::cmd_bench(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    
+    uint32_t samples = Benchmark::DEFAULT_SAMPLES;
+    if (!args.empty() && (parse_numbers(args, &samples, 1) != 1 || samples == 0 || samples > Benchmark::MAX_SAMPLES)) {
+        serial.print("Error: Samples must be 1-", Benchmark::MAX_SAMPLES, '\n');
+        return;
+    }
+    
+    const BenchResult result = Benchmark::instance().run(samples);
+    
+    serial.print("bench: profile=", Benchmark::profile_name(), " clk_sys=", ClockGovernor::instance().get_sys_hz() / 1000000,
+                 "MHz samples=", result.samples, '\n');
+    
+    const std::pair<const char*, const BenchStats*> rows[] = {
+        {"isr_warm", &result.isr_warm},
+        {"isr_cold", &result.isr_cold},
+        {"frame_warm", &result.frame_warm},
+        {"frame_cold", &result.frame_cold},
+        {"gradient_float", &result.gradient_float},
+        {"gradient_interp", &result.gradient_interp},
+    };
+    for (const auto& [name, stats] : rows) {
+        serial.print("  ", name, ": min=", stats->min_ns, " mean=", stats->mean_ns, " max=", stats->max_ns,
+                     " stddev=", stats->stddev_ns, " ns\n");
+    }
+}
+
+void CommandHandler::cmd_layer_animate(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: layer mode [speed]
+    uint32_t layer = 0;
+    if (parse_numbers(args, &layer, 1) != 1 || !ws2812.is_layer_valid(layer)) {
+        constexpr std::string_view error_msg = "Error: layer_animate requires: layer mode [speed]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    args = args.substr(std::min(args.find(' '), args.size()));
+    args = args.substr(std::min(args.find_first_not_of(" \t"), args.size()));
+    auto space_pos = args.find(' ');
+    std::string_view mode_str = args.substr(0, space_pos);
+    
+    auto mode = parse_animation_mode(mode_str);
+    if (!mode) {
+        constexpr std::string_view error_msg = "Error: Invalid animation mode. Use: static, fade, rainbow, chase, pulse, sparkle\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    uint32_t speed = 100;  // Default speed
+    if (space_pos != std::string_view::npos) {
+        (void)parse_numbers(args.substr(space_pos + 1), &speed, 1);
+    }
+    speed = std::clamp(speed, MIN_ANIMATION_SPEED_MS, MAX_ANIMATION_SPEED_MS);
+    
+    ws2812.set_layer_animation(layer, *mode, speed);
+    
+    serial.print("Layer ", layer, " animation set to ", mode_str, " (speed: ", speed, "ms)\n");
+}
+
+void CommandHandler::cmd_layer_color(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: layer r g b [r2 g2 b2]
+    uint32_t values[7] = {};
+    size_t parsed = parse_numbers(args, values, 7);
+    
+    if (parsed != 4 && parsed != 7) {
+        constexpr std::string_view error_msg = "Error: layer_color requires: layer r g b [r2 g2 b2]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (!ws2812.is_layer_valid(values[0])) {
+        constexpr std::string_view error_msg = "Error: Invalid layer index\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (std::any_of(values + 1, values + parsed, [](uint32_t v) { return v > 255; })) {
+        constexpr std::string_view error_msg = "Error: RGB values must be 0-255\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    RGB primary(values[1], values[2], values[3]);
+    RGB secondary(values[4], values[5], values[6]);
+    ws2812.set_layer_colors(values[0], primary, secondary);
+    
+    // A static layer shows its primary color directly
+    if (ws2812.get_layer(values[0]).animation == AnimationMode::STATIC) {
+        ws2812.set_layer_fill(values[0], primary);
+    }
+    
+    serial.print("Layer ", values[0], " colors set\n");
+}
+
+void CommandHandler::cmd_layer_blend(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: layer mode [opacity]
+    uint32_t layer = 0;
+    if (parse_numbers(args, &layer, 1) != 1 || !ws2812.is_layer_valid(layer)) {
+        constexpr std::string_view error_msg = "Error: layer_blend requires: layer mode [opacity]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    args = args.substr(std::min(args.find(' '), args.size()));
+    args = args.substr(std::min(args.find_first_not_of(" \t"), args.size()));
+    auto space_pos = args.find(' ');
+    std::string_view mode_str = args.substr(0, space_pos);
+    
+    BlendMode mode;
+    if (str_equal_case_insensitive(mode_str, "normal")) {
+        mode = BlendMode::NORMAL;
+    } else if (str_equal_case_insensitive(mode_str, "add")) {
+        mode = BlendMode::ADD;
+    } else if (str_equal_case_insensitive(mode_str, "multiply")) {
+        mode = BlendMode::MULTIPLY;
+    } else if (str_equal_case_insensitive(mode_str, "max")) {
+        mode = BlendMode::MAX;
+    } else {
+        constexpr std::string_view error_msg = "Error: Invalid blend mode. Use: normal, add, multiply, max\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    uint32_t opacity = 255;
+    if (space_pos != std::string_view::npos) {
+        (void)parse_numbers(args.substr(space_pos + 1), &opacity, 1);
+    }
+    
+    if (opacity > 255) {
+        constexpr std::string_view error_msg = "Error: Opacity must be 0-255\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    ws2812.set_layer_blend(layer, mode, opacity);
+    
+    serial.print("Layer ", layer, " blend set to ", mode_str, " (opacity: ", opacity, ")\n");
+}
+
+void CommandHandler::cmd_layer_mask(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: layer strip_mask [start count]
+    uint32_t values[4] = {0, 0, 0, LEDS_PER_STRIP};
+    size_t parsed = parse_numbers(args, values, 4);
+    
+    if (parsed != 2 && parsed != 4) {
+        constexpr std::string_view error_msg = "Error: layer_mask requires: layer strip_mask [start count]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (!ws2812.is_layer_valid(values[0])) {
+        constexpr std::string_view error_msg = "Error: Invalid layer index\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (values[1] >= (1u << NUM_STRIPS) || values[2] >= LEDS_PER_STRIP ||
+        values[3] == 0 || values[3] > LEDS_PER_STRIP - values[2]) {
+        constexpr std::string_view error_msg = "Error: Invalid strip mask or LED range\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    ws2812.set_layer_mask(values[0], values[1], values[2], values[3]);
+    
+    serial.print("Layer ", values[0], " mask set: strips 0x", Hex{values[1]}, ", leds ", values[2], '+', values[3], '\n');
+}
+
+void CommandHandler::cmd_layer_off(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    uint32_t layer = 0;
+    if (parse_numbers(args, &layer, 1) != 1 || !ws2812.is_layer_valid(layer) || layer == BASE_LAYER) {
+        constexpr std::string_view error_msg = "Error: layer_off requires an overlay layer index\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    ws2812.set_layer_enabled(layer, false);
+    
+    serial.print("Layer ", layer, " disabled\n");
+}
+
+void CommandHandler::cmd_zone_define(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: name strip start count [strip start count ...]
+    std::string_view name = take_word(args);
+    uint32_t values[3 * MAX_ZONE_RANGES] = {};
+    size_t parsed = parse_numbers(args, values, 3 * MAX_ZONE_RANGES);
+    
+    if (name.empty() || parsed == 0 || parsed % 3 != 0) {
+        constexpr std::string_view error_msg = "Error: zone_define requires: name strip start count [strip start count ...]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    std::array<ZoneRange, MAX_ZONE_RANGES> ranges{};
+    const uint range_count = parsed / 3;
+    for (uint i = 0; i < range_count; i++) {
+        if (values[i * 3] >= NUM_STRIPS || values[i * 3 + 1] >= LEDS_PER_STRIP || values[i * 3 + 2] > LEDS_PER_STRIP) {
+            constexpr std::string_view error_msg = "Error: Invalid zone range\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+        ranges[i] = ZoneRange{(uint8_t)values[i * 3], (uint8_t)values[i * 3 + 1], (uint8_t)values[i * 3 + 2]};
+    }
+    
+    if (!ws2812.define_zone(name, ranges.data(), range_count)) {
+        serial.print("Error: Zone rejected (name 1-", ZONE_NAME_MAX, " chars, ranges within strips, max ",
+                     MAX_ZONES, " zones)\n");
+        return;
+    }
+    
+    serial.print("Zone ", name, " defined: ", range_count, " ranges, ", ws2812.get_zone(ws2812.find_zone(name)).length, " leds\n");
+}
+
+void CommandHandler::cmd_zone_delete(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    std::string_view name = take_word(args);
+    if (!ws2812.delete_zone(name)) {
+        constexpr std::string_view error_msg = "Error: Unknown zone\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    serial.print("Zone ", name, " deleted\n");
+}
+
+void CommandHandler::cmd_zone_fill(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: name r g b [offset count]
+    std::string_view name = take_word(args);
+    const int zone = ws2812.find_zone(name);
+    uint32_t values[5] = {0, 0, 0, 0, UINT32_MAX};
+    size_t parsed = parse_numbers(args, values, 5);
+    
+    if (zone < 0 || (parsed != 3 && parsed != 5)) {
+        constexpr std::string_view error_msg = "Error: zone_fill requires: zone r g b [offset count]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (std::any_of(values, values + 3, [](uint32_t v) { return v > 255; })) {
+        constexpr std::string_view error_msg = "Error: RGB values must be 0-255\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (!ws2812.set_zone_fill(zone, values[3], values[4], RGB(values[0], values[1], values[2]))) {
+        serial.print("Error: Zone ", name, " would exceed ", MAX_ZONE_RUNS, " runs\n");
+        return;
+    }
+    
+    serial.print("Zone ", name, " filled (", ws2812.get_zone(zone).run_count, " runs)\n");
+}
+
+void CommandHandler::cmd_zone_gradient(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: name r1 g1 b1 r2 g2 b2 [offset count]
+    std::string_view name = take_word(args);
+    const int zone = ws2812.find_zone(name);
+    uint32_t values[8] = {0, 0, 0, 0, 0, 0, 0, UINT32_MAX};
+    size_t parsed = parse_numbers(args, values, 8);
+    
+    if (zone < 0 || (parsed != 6 && parsed != 8)) {
+        constexpr std::string_view error_msg = "Error: zone_gradient requires: zone r1 g1 b1 r2 g2 b2 [offset count]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (std::any_of(values, values + 6, [](uint32_t v) { return v > 255; })) {
+        constexpr std::string_view error_msg = "Error: RGB values must be 0-255\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    RGB start_color(values[0], values[1], values[2]);
+    RGB end_color(values[3], values[4], values[5]);
+    if (!ws2812.set_zone_gradient(zone, values[6], values[7], start_color, end_color)) {
+        serial.print("Error: Zone ", name, " would exceed ", MAX_ZONE_RUNS, " runs\n");
+        return;
+    }
+    
+    serial.print("Zone ", name, " gradient set (", ws2812.get_zone(zone).run_count, " runs)\n");
+}
+
+void CommandHandler::cmd_zone_animate(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: name mode [speed] [r g b [r2 g2 b2]]
+    std::string_view name = take_word(args);
+    const int zone = ws2812.find_zone(name);
+    std::string_view mode_str = take_word(args);
+    
+    if (zone < 0) {
+        constexpr std::string_view error_msg = "Error: zone_animate requires: zone mode [speed] [r g b [r2 g2 b2]]\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    auto mode = parse_animation_mode(mode_str);
+    if (!mode || *mode == AnimationMode::SPARKLE) {
+        constexpr std::string_view error_msg = "Error: Invalid zone animation. Use: static, fade, rainbow, chase, pulse\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    // Colors default to the zone's previous animation colors
+    const Zone& current = ws2812.get_zone(zone);
+    uint32_t values[7] = {100,
+                          current.primary_color.r, current.primary_color.g, current.primary_color.b,
+                          current.secondary_color.r, current.secondary_color.g, current.secondary_color.b};
+    size_t parsed = parse_numbers(args, values, 7);
+    
+    if (parsed == 2 || parsed == 3 || parsed == 5 || parsed == 6) {
+        constexpr std::string_view error_msg = "Error: zone_animate colors need all of r g b\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (std::any_of(values + 1, values + 7, [](uint32_t v) { return v > 255; })) {
+        constexpr std::string_view error_msg = "Error: RGB values must be 0-255\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    RGB primary(values[1], values[2], values[3]);
+    RGB secondary(values[4], values[5], values[6]);
+    const uint32_t speed = std::clamp(values[0], MIN_ANIMATION_SPEED_MS, MAX_ANIMATION_SPEED_MS);
+    (void)ws2812.set_zone_animation(zone, *mode, speed, primary, secondary);
+    
+    serial.print("Zone ", name, " animation set to ", mode_str, " (speed: ", speed, "ms)\n");
+}
+
+void CommandHandler::cmd_zones([[maybe_unused]] std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    uint count = 0;
+    for (uint i = 0; i < MAX_ZONES; i++) {
+        if (!ws2812.is_zone_valid(i)) continue;
+        
+        const Zone& zone = ws2812.get_zone(i);
+        serial.append("zone ", zone.get_name(), ": leds=", zone.length, " ranges=");
+        for (uint r = 0; r < zone.range_count; r++) {
+            const ZoneRange& range = zone.ranges[r];
+            serial.append(r ? "," : "", range.strip, ':', range.start, '+', range.count);
+        }
+        serial.append(" runs=", zone.run_count, " animation=");
+        for (const auto& [mode_name, mode] : animation_modes) {
+            if (mode == zone.animation) serial.append(mode_name);
+        }
+        serial.print('\n');
+        count++;
+    }
+    
+    if (count == 0) {
+        serial.print("No zones defined\n");
+    }
+}
+
+void CommandHandler::cmd_effect_begin([[maybe_unused]] std::string_view args) {
+    EffectVM::instance().begin();
+    USBSerial::instance().print("Effect upload started\n");
+}
+
+void CommandHandler::cmd_effect_data(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    
+    // Hex bytes; whitespace between them is ignored
+    std::array<uint8_t, 128> bytes;
+    size_t count = 0;
+    int high = -1;
+    for (char c : args) {
+        if (c == ' ' || c == '\t') continue;
+        
+        int nibble = -1;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        
+        if (nibble < 0 || (high < 0 && count == bytes.size())) {
+            constexpr std::string_view error_msg = "Error: effect_data requires hex bytes\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+        
+        if (high < 0) {
+            high = nibble;
+        } else {
+            bytes[count++] = (high << 4) | nibble;
+            high = -1;
+        }
+    }
+    
+    if (high >= 0 || count == 0) {
+        constexpr std::string_view error_msg = "Error: effect_data requires whole hex bytes\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    EffectVM& vm = EffectVM::instance();
+    if (!vm.append(bytes.data(), count)) {
+        serial.print("Error: Effect program exceeds ", MAX_EFFECT_INSTRUCTIONS, " instructions\n");
+        return;
+    }
+    
+    serial.print("Effect data: ", vm.get_staging_length(), " bytes\n");
+}
+
+void CommandHandler::cmd_effect_commit(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    EffectVM& vm = EffectVM::instance();
+    
+    uint32_t slot = 0;
+    if (parse_numbers(args, &slot, 1) != 1 || slot >= MAX_EFFECTS) {
+        serial.print("Error: effect_commit requires a slot 0-", MAX_EFFECTS - 1, '\n');
+        return;
+    }
+    
+    if (!vm.commit(slot)) {
+        serial.print("Error: Effect rejected at instruction ", vm.get_error_instruction(), ": ", vm.get_error_reason(), '\n');
+        return;
+    }
+    
+    serial.print("Effect ", slot, " loaded: ", vm.get_length(slot), " instructions\n");
+}
+
+void CommandHandler::cmd_effects([[maybe_unused]] std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    EffectVM& vm = EffectVM::instance();
+    
+    for (uint slot = 0; slot < MAX_EFFECTS; slot++) {
+        serial.print("effect ", slot, ": ", vm.get_length(slot), " instructions\n");
+    }
+}
+
+void CommandHandler::cmd_layer_effect(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Parse: layer slot
+    uint32_t values[2] = {};
+    if (parse_numbers(args, values, 2) != 2 || !ws2812.is_layer_valid(values[0])) {
+        constexpr std::string_view error_msg = "Error: layer_effect requires: layer slot\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    if (!EffectVM::instance().is_loaded(values[1])) {
+        constexpr std::string_view error_msg = "Error: No effect loaded in that slot\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    ws2812.set_layer_effect(values[0], values[1]);
+    
+    serial.print("Layer ", values[0], " running effect ", values[1], '\n');
+}
+
+void CommandHandler::cmd_audio(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    AudioOutput& audio = AudioOutput::instance();
+    
+    std::string_view action = take_word(args);
+    if (str_equal_case_insensitive(action, "on")) {
+        audio.set_enabled(true);
+    } else if (str_equal_case_insensitive(action, "off")) {
+        audio.set_enabled(false);
+    } else if (str_equal_case_insensitive(action, "volume")) {
+        uint32_t volume = 0;
+        if (parse_numbers(args, &volume, 1) != 1 || volume > 255) {
+            constexpr std::string_view error_msg = "Error: audio volume requires 0-255\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+        audio.set_volume(volume);
+    } else if (!action.empty()) {
+        bool found = false;
+        for (size_t i = 0; i < (size_t)Sound::COUNT; i++) {
+            if (str_equal_case_insensitive(action, AudioOutput::sound_name((Sound)i))) {
+                audio.play((Sound)i);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            constexpr std::string_view error_msg = "Error: audio accepts on, off, buzzer, expired, volume <0-255>\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+    }
+    
+    serial.print("audio: enabled=", audio.is_enabled(), " volume=", audio.get_volume(), " playing=", audio.is_playing(),
+                 " plays=", audio.get_plays(), " start=", audio.get_last_start_us(), "us\n");
+}
+
+void CommandHandler::cmd_timer_default(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    Feud& feud = Feud::instance();
+    
+    uint32_t duration = 0;
+    if (parse_numbers(args, &duration, 1) != 1 || duration > MAX_TIMER_SECONDS) {
+        constexpr std::string_view error_msg = "Error: timer_default requires 0-300 seconds (0 = none)\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+        return;
+    }
+    
+    feud.set_default_duration(duration);
+    
+    serial.print("Default timer set to ", duration, " seconds\n");
+}
+
+void CommandHandler::cmd_save([[maybe_unused]] std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    ConfigStore& store = ConfigStore::instance();
+    
+    // The flash write is deferred to the main loop, between frames of an idle game
+    store.request_save();
+    
+    if (Feud::instance().get_state() != GameState::IDLE) {
+        constexpr std::string_view response = "Settings will be saved when the round ends\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(response.data()), response.size());
+        return;
+    }
+    constexpr std::string_view response = "Settings will be saved\n";
+    serial.send_data(reinterpret_cast<const uint8_t*>(response.data()), response.size());
+}
+
+void CommandHandler::cmd_config(std::string_view args) {
+    USBSerial& serial = USBSerial::instance();
+    ConfigStore& store = ConfigStore::instance();
+    
+    if (str_equal_case_insensitive(args, "clear")) {
+        if (!store.clear()) {
+            constexpr std::string_view error_msg = "Error: config clear requires idle game and a successful flash erase\n";
+            serial.send_data(reinterpret_cast<const uint8_t*>(error_msg.data()), error_msg.size());
+            return;
+        }
+        constexpr std::string_view response = "Saved settings erased\n";
+        serial.send_data(reinterpret_cast<const uint8_t*>(response.data()), response.size());
+        return;
+    }
+    
+    serial.print("config: saved=", store.has_saved_config(),
+                 " sequence=", store.get_sequence(),
+                 " slots=", store.get_slot_count(),
+                 " restore=", store.get_restore_time_us(),
+                 "us last_write=", store.get_last_write_time_us(),
+                 "us pending=", store.is_save_pending(), '\n');
 }
@@ -7,6 +7,8 @@
 #include <string_view>
 #include <optional>
 
+#include "ws2812_controller.h"
+
 class CommandHandler {
  private:
     bool initialized = false;
@@ -22,19 +24,49 @@ class CommandHandler {
     static void cmd_resume_timer(std::string_view args);
     static void cmd_reset_game(std::string_view args);
     static void cmd_force_reset(std::string_view args);
+    static void cmd_timer_default(std::string_view args);
+    static void cmd_save(std::string_view args);
+    static void cmd_config(std::string_view args);
+    static void cmd_players(std::string_view args);
     static void cmd_led_set(std::string_view args);
     static void cmd_led_strip(std::string_view args);
     static void cmd_led_all(std::string_view args);
     static void cmd_led_clear(std::string_view args);
     static void cmd_led_animate(std::string_view args);
     static void cmd_led_brightness(std::string_view args);
+    static void cmd_led_dither(std::string_view args);
+    static void cmd_led_driver(std::string_view args);
+    static void cmd_frame_rate(std::string_view args);
+    static void cmd_frame_stats(std::string_view args);
+    static void cmd_clock(std::string_view args);
+    static void cmd_pio_stats(std::string_view args);
+    static void cmd_time_sync(std::string_view args);
+    static void cmd_bench(std::string_view args);
+    static void cmd_layer_animate(std::string_view args);
+    static void cmd_layer_color(std::string_view args);
+    static void cmd_layer_blend(std::string_view args);
+    static void cmd_layer_mask(std::string_view args);
+    static void cmd_layer_off(std::string_view args);
+    static void cmd_zone_define(std::string_view args);
+    static void cmd_zone_delete(std::string_view args);
+    static void cmd_zone_fill(std::string_view args);
+    static void cmd_zone_gradient(std::string_view args);
+    static void cmd_zone_animate(std::string_view args);
+    static void cmd_zones(std::string_view args);
+    static void cmd_effect_begin(std::string_view args);
+    static void cmd_effect_data(std::string_view args);
+    static void cmd_effect_commit(std::string_view args);
+    static void cmd_effects(std::string_view args);
+    static void cmd_layer_effect(std::string_view args);
+    static void cmd_audio(std::string_view args);
+    static void cmd_usbstats(std::string_view args);
     
     struct Command {
         std::string_view name;
         CommandFunction handler;
     };
     
-    static constexpr std::array<Command, 15> commands{{
+    static constexpr std::array<Command, 45> commands{{
         {"hello", cmd_hello},
         {"status", cmd_status},
         {"help", cmd_help},
@@ -44,12 +76,42 @@ class CommandHandler {
         {"resume_timer", cmd_resume_timer},
         {"reset_game", cmd_reset_game},
         {"force_reset", cmd_force_reset},
+        {"timer_default", cmd_timer_default},
+        {"save", cmd_save},
+        {"config", cmd_config},
+        {"players", cmd_players},
         {"led_set", cmd_led_set},
         {"led_strip", cmd_led_strip},
         {"led_all", cmd_led_all},
         {"led_clear", cmd_led_clear},
         {"led_animate", cmd_led_animate},
-        {"led_brightness", cmd_led_brightness}
+        {"led_brightness", cmd_led_brightness},
+        {"led_dither", cmd_led_dither},
+        {"led_driver", cmd_led_driver},
+        {"frame_rate", cmd_frame_rate},
+        {"frame_stats", cmd_frame_stats},
+        {"clock", cmd_clock},
+        {"pio_stats", cmd_pio_stats},
+        {"time_sync", cmd_time_sync},
+        {"bench", cmd_bench},
+        {"layer_animate", cmd_layer_animate},
+        {"layer_color", cmd_layer_color},
+        {"layer_blend", cmd_layer_blend},
+        {"layer_mask", cmd_layer_mask},
+        {"layer_off", cmd_layer_off},
+        {"zone_define", cmd_zone_define},
+        {"zone_delete", cmd_zone_delete},
+        {"zone_fill", cmd_zone_fill},
+        {"zone_gradient", cmd_zone_gradient},
+        {"zone_animate", cmd_zone_animate},
+        {"zones", cmd_zones},
+        {"effect_begin", cmd_effect_begin},
+        {"effect_data", cmd_effect_data},
+        {"effect_commit", cmd_effect_commit},
+        {"effects", cmd_effects},
+        {"layer_effect", cmd_layer_effect},
+        {"audio", cmd_audio},
+        {"usbstats", cmd_usbstats}
     }};
     
     void init();
@@ -57,6 +119,9 @@ class CommandHandler {
     [[nodiscard]] static constexpr bool str_equal_case_insensitive(std::string_view a, std::string_view b) noexcept;
     [[nodiscard]] std::string_view trim_whitespace(std::string_view str) const noexcept;
     [[nodiscard]] std::optional<std::pair<std::string_view, std::string_view>> parse_command_line(std::string_view line) const noexcept;
+    [[nodiscard]] static size_t parse_numbers(std::string_view args, uint32_t* values, size_t max_values) noexcept;
+    [[nodiscard]] static std::optional<AnimationMode> parse_animation_mode(std::string_view name) noexcept;
+    [[nodiscard]] static std::string_view take_word(std::string_view& args) noexcept;
     
  public:
     static CommandHandler& instance();
@@ -0,0 +1,289 @@
+#include "config_store.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "pico/flash.h"
+#include "pico/stdlib.h"
+
+// The log occupies the last sectors of flash, read back through XIP
+static constexpr uint32_t CONFIG_FLASH_OFFSET = PICO_FLASH_SIZE_BYTES - 2 * FLASH_SECTOR_SIZE;
+static constexpr uint SLOTS_PER_SECTOR = FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE;
+
+struct FlashWriteOp {
+    uint32_t offset;
+    bool erase_sector;
+    const uint8_t* page;
+};
+
+// Runs with XIP unavailable, so it must execute from RAM
+static void __not_in_flash_func(flash_write_page)(void* param) {
+    const FlashWriteOp* op = static_cast<const FlashWriteOp*>(param);
+    if (op->erase_sector) {
+        flash_range_erase(op->offset & ~(FLASH_SECTOR_SIZE - 1), FLASH_SECTOR_SIZE);
+    }
+    if (op->page) {
+        flash_range_program(op->offset, op->page, FLASH_PAGE_SIZE);
+    }
+}
+
+ConfigStore& ConfigStore::instance() {
+    static ConfigStore store;
+    if (!store.initialized) {
+        store.initialized = true;
+        store.init();
+    }
+    return store;
+}
+
+void ConfigStore::init() {
+    static_assert(sizeof(ConfigRecord) <= FLASH_PAGE_SIZE);
+    static_assert(sizeof(LegacyConfig) == 36 && sizeof(LegacyRecord) == 48);
+    static_assert(CONFIG_SECTOR_COUNT * FLASH_SECTOR_SIZE == PICO_FLASH_SIZE_BYTES - CONFIG_FLASH_OFFSET);
+    
+    const uint32_t start = time_us_32();
+    scan();
+    scan_time_us = time_us_32() - start;
+}
+
+uint ConfigStore::get_slot_count() const {
+    return CONFIG_SECTOR_COUNT * SLOTS_PER_SECTOR;
+}
+
+uint32_t ConfigStore::slot_offset(uint slot) {
+    return CONFIG_FLASH_OFFSET + slot * FLASH_PAGE_SIZE;
+}
+
+const ConfigStore::ConfigRecord* ConfigStore::slot_record(uint slot) {
+    return reinterpret_cast<const ConfigRecord*>(XIP_BASE + slot_offset(slot));
+}
+
+bool ConfigStore::slot_erased(uint slot) {
+    const uint8_t* page = reinterpret_cast<const uint8_t*>(slot_record(slot));
+    return std::all_of(page, page + FLASH_PAGE_SIZE, [](uint8_t b) { return b == 0xFF; });
+}
+
+uint32_t ConfigStore::crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t ConfigStore::record_crc(const ConfigRecord& record) {
+    // The sequence and version are covered too: a corrupted sequence could
+    // make a stale record win
+    constexpr size_t start = offsetof(ConfigRecord, sequence);
+    constexpr size_t end = offsetof(ConfigRecord, crc);
+    return crc32(reinterpret_cast<const uint8_t*>(&record) + start, end - start);
+}
+
+void ConfigStore::scan() {
+    has_config = false;
+    sequence = 0;
+    next_slot = 0;
+    
+    // Records are appended in order, so the newest valid record has the
+    // highest sequence number and the slot after it is the next to write
+    for (uint slot = 0; slot < get_slot_count(); slot++) {
+        uint32_t record_sequence;
+        PersistentConfig decoded;
+        if (!read_record(slot, record_sequence, decoded)) continue;
+        if (has_config && record_sequence <= sequence) continue;
+        
+        has_config = true;
+        sequence = record_sequence;
+        config = decoded;
+        next_slot = (slot + 1) % get_slot_count();
+    }
+}
+
+bool ConfigStore::read_record(uint slot, uint32_t& record_sequence, PersistentConfig& decoded) const {
+    const ConfigRecord* record = slot_record(slot);
+    if (record->magic == CONFIG_MAGIC) {
+        // A newer layout than this firmware knows is left alone
+        if (record->version != CONFIG_VERSION || record_crc(*record) != record->crc) return false;
+        record_sequence = record->sequence;
+        decoded = record->config;
+        return true;
+    }
+    
+    if (record->magic == LEGACY_MAGIC) {
+        const LegacyRecord* legacy = reinterpret_cast<const LegacyRecord*>(record);
+        const uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(&legacy->config), sizeof(legacy->config));
+        if (crc != legacy->crc) return false;
+        record_sequence = legacy->sequence;
+        decoded = migrate(legacy->config);
+        return true;
+    }
+    return false;
+}
+
+PersistentConfig ConfigStore::migrate(const LegacyConfig& legacy) {
+    PersistentConfig migrated{};
+    migrated.brightness_percent = legacy.brightness_percent;
+    migrated.animation_mode = legacy.animation_mode;
+    migrated.dithering = legacy.dithering;
+    migrated.player_count = legacy.player_count;
+    migrated.animation_speed = legacy.animation_speed;
+    migrated.primary_color = legacy.primary_color;
+    migrated.secondary_color = legacy.secondary_color;
+    migrated.frame_rate_hz = legacy.frame_rate_hz;
+    migrated.default_timer_s = legacy.default_timer_s;
+    memcpy(migrated.player_pins, legacy.player_pins, sizeof(migrated.player_pins));
+    
+    // The oldest records have padding here; anything that isn't a chip
+    // reads as WS2812, the only chip those builds drove
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        migrated.strip_chips[i] = (legacy.strip_chips[i] < (uint8_t)LedChip::COUNT) ? legacy.strip_chips[i]
+                                                                                    : (uint8_t)LedChip::WS2812;
+    }
+    return migrated;
+}
+
+bool ConfigStore::restore() {
+    const uint32_t start = time_us_32();
+    
+    if (has_config) {
+        apply(config);
+    }
+    
+    // Finding the newest record is part of restoring it
+    restore_time_us = scan_time_us + (time_us_32() - start);
+    return has_config;
+}
+
+PersistentConfig ConfigStore::capture() const {
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    Feud& feud = Feud::instance();
+    const Layer& base = ws2812.get_layer(BASE_LAYER);
+    
+    PersistentConfig captured{};
+    captured.brightness_percent = (uint8_t)(ws2812.get_brightness() * 100.0f + 0.5f);
+    captured.animation_mode = (uint8_t)base.animation;
+    captured.dithering = ws2812.is_dithering() ? 1 : 0;
+    captured.animation_speed = base.animation_speed;
+    captured.primary_color = base.primary_color;
+    captured.secondary_color = base.secondary_color;
+    captured.frame_rate_hz = ws2812.get_frame_rate();
+    captured.default_timer_s = feud.get_default_duration();
+    captured.player_count = feud.get_player_count();
+    for (uint i = 0; i < feud.get_player_count(); i++) {
+        captured.player_pins[i][0] = feud.get_player_config(i).button_pin;
+        captured.player_pins[i][1] = feud.get_player_config(i).led_pin;
+    }
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        captured.strip_chips[i] = (uint8_t)ws2812.get_strip_chip(i);
+    }
+    return captured;
+}
+
+void ConfigStore::apply(const PersistentConfig& restored) const {
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    Feud& feud = Feud::instance();
+    
+    // Each setter rejects or clamps what it can't use, so one bad field
+    // keeps its default without costing the others
+    
+    // Chips first: they bound the frame rate
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        ws2812.set_strip_chip(i, (LedChip)restored.strip_chips[i]);
+    }
+    ws2812.set_brightness(restored.brightness_percent / 100.0f);
+    ws2812.set_frame_rate(restored.frame_rate_hz);
+    ws2812.set_dithering(restored.dithering != 0);
+    ws2812.set_animation_colors(restored.primary_color, restored.secondary_color);
+    if (restored.animation_mode <= (uint8_t)AnimationMode::SPARKLE) {
+        ws2812.set_animation((AnimationMode)restored.animation_mode, restored.animation_speed);
+    }
+    
+    feud.set_default_duration(restored.default_timer_s <= MAX_TIMER_SECONDS ? restored.default_timer_s : 0);
+    
+    std::array<PlayerConfig, MAX_PLAYERS> players{};
+    const uint count = std::min<uint>(restored.player_count, MAX_PLAYERS);
+    for (uint i = 0; i < count; i++) {
+        players[i] = PlayerConfig{restored.player_pins[i][0], restored.player_pins[i][1]};
+    }
+    feud.configure_players(players.data(), count);
+}
+
+void ConfigStore::request_save() {
+    pending_config = capture();
+    save_pending = true;
+}
+
+void ConfigStore::update() {
+    if (!save_pending) return;
+    
+    // Interrupts are masked for the whole program or erase: button IRQs and
+    // frame ticks would be held off for that long, so a save requested
+    // during a round waits for it to end. Called right after the frame has
+    // been handed to DMA, which keeps clocking the strips out of RAM.
+    if (Feud::instance().get_state() != GameState::IDLE) return;
+    
+    if (write(pending_config)) {
+        save_pending = false;
+    }
+}
+
+bool ConfigStore::write(const PersistentConfig& new_config) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    
+    ConfigRecord record{};
+    record.magic = CONFIG_MAGIC;
+    record.sequence = has_config ? sequence + 1 : 0;
+    record.version = CONFIG_VERSION;
+    record.config = new_config;
+    record.crc = record_crc(record);
+    
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &record, sizeof(record));
+    
+    // A slot left dirty by an interrupted write is skipped, not erased: its
+    // sector still holds the newest record. Only entering a sector erases,
+    // and the newest record is then in the sector before it.
+    uint slot = next_slot;
+    while ((slot % SLOTS_PER_SECTOR) != 0 && !slot_erased(slot)) {
+        slot = (slot + 1) % get_slot_count();
+    }
+    FlashWriteOp op{slot_offset(slot), (slot % SLOTS_PER_SECTOR) == 0, page};
+    
+    const uint32_t start = time_us_32();
+    if (flash_safe_execute(flash_write_page, &op, 100) != PICO_OK) {
+        return false;
+    }
+    last_write_time_us = time_us_32() - start;
+    
+    has_config = true;
+    sequence = record.sequence;
+    config = new_config;
+    next_slot = (slot + 1) % get_slot_count();
+    return true;
+}
+
+bool ConfigStore::clear() {
+    if (Feud::instance().get_state() != GameState::IDLE) return false;
+    
+    save_pending = false;
+    
+    // Forget the log only once every sector is erased; a sector that could
+    // not be erased is retried by the next clear
+    bool cleared = true;
+    for (uint sector = 0; sector < CONFIG_SECTOR_COUNT; sector++) {
+        FlashWriteOp op{CONFIG_FLASH_OFFSET + sector * FLASH_SECTOR_SIZE, true, nullptr};
+        if (flash_safe_execute(flash_write_page, &op, 100) != PICO_OK) {
+            cleared = false;
+        }
+    }
+    
+    // Whatever survived is still the log
+    scan();
+    return cleared;
+}
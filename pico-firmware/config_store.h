@@ -0,0 +1,123 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feud.h"
+#include "ws2812_controller.h"
+
+// Settings restored at boot. A layout change bumps ConfigStore's
+// CONFIG_VERSION, and scan() learns to migrate the previous layout.
+struct PersistentConfig {
+    uint8_t brightness_percent;
+    uint8_t animation_mode;
+    uint8_t dithering;
+    uint8_t player_count;
+    uint32_t animation_speed;
+    RGB primary_color;
+    RGB secondary_color;
+    uint16_t frame_rate_hz;
+    uint16_t default_timer_s;
+    uint8_t player_pins[MAX_PLAYERS][2];  // button, led
+    uint8_t strip_chips[NUM_STRIPS];      // LedChip per strip
+};
+
+// Append-only config log in the last flash sectors. Each save programs the
+// next free page; when a sector fills up the log moves on to the next
+// sector, erasing it first, so erases rotate across all sectors. Flash
+// writes mask interrupts for milliseconds (tens for an erase), so they
+// only happen while the game is idle and no button press can be missed.
+class ConfigStore {
+ private:
+    bool initialized = false;
+    
+    static constexpr uint32_t CONFIG_MAGIC = 0x32444546;  // "FED2"
+    static constexpr uint32_t CONFIG_VERSION = 2;
+    static constexpr uint CONFIG_SECTOR_COUNT = 2;
+    
+    struct ConfigRecord {
+        uint32_t magic;
+        uint32_t sequence;
+        uint32_t version;           // Layout of config
+        PersistentConfig config;
+        uint32_t crc;               // Over sequence, version and config
+    };
+    
+    // Records from before the version field, migrated on restore. Their
+    // CRC covers only the payload, whose last two bytes were padding until
+    // strip_chips took them.
+    static constexpr uint32_t LEGACY_MAGIC = 0x46455544;  // "FEUD"
+    
+    struct LegacyConfig {
+        uint8_t brightness_percent;
+        uint8_t animation_mode;
+        uint8_t dithering;
+        uint8_t player_count;
+        uint32_t animation_speed;
+        RGB primary_color;
+        RGB secondary_color;
+        uint16_t frame_rate_hz;
+        uint16_t default_timer_s;
+        uint8_t player_pins[MAX_PLAYERS][2];
+        uint8_t strip_chips[NUM_STRIPS];  // Padding in the oldest records
+    };
+    
+    struct LegacyRecord {
+        uint32_t magic;
+        uint32_t sequence;
+        LegacyConfig config;
+        uint32_t crc;
+    };
+    
+    // Log position, found by scanning at boot
+    bool has_config = false;
+    uint32_t sequence = 0;
+    uint next_slot = 0;
+    PersistentConfig config{};
+    
+    // Deferred write requested by the save command
+    bool save_pending = false;
+    PersistentConfig pending_config{};
+    
+    uint32_t scan_time_us = 0;
+    uint32_t restore_time_us = 0;
+    uint32_t last_write_time_us = 0;
+    
+    void init();
+    void scan();
+    bool read_record(uint slot, uint32_t& record_sequence, PersistentConfig& decoded) const;
+    static PersistentConfig migrate(const LegacyConfig& legacy);
+    bool write(const PersistentConfig& new_config);
+    PersistentConfig capture() const;
+    void apply(const PersistentConfig& restored) const;
+    
+    static const ConfigRecord* slot_record(uint slot);
+    static uint32_t slot_offset(uint slot);
+    static bool slot_erased(uint slot);
+    static uint32_t crc32(const uint8_t* data, size_t length);
+    static uint32_t record_crc(const ConfigRecord& record);
+    
+ public:
+    static ConfigStore& instance();
+    
+    // Applies the stored config; returns false if none was found
+    bool restore();
+    
+    // Snapshots the current settings; the flash write happens in update()
+    // once the game is idle
+    void request_save();
+    bool is_save_pending() const { return save_pending; }
+    
+    // Erases every record; refused while a round is in play
+    bool clear();
+    void update();
+    
+    bool has_saved_config() const { return has_config; }
+    uint32_t get_sequence() const { return sequence; }
+    uint get_slot_count() const;
+    uint32_t get_restore_time_us() const { return restore_time_us; }
+    uint32_t get_last_write_time_us() const { return last_write_time_us; }
+};
+
+#endif  // CONFIG_STORE_H
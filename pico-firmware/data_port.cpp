@@ -0,0 +1,159 @@
+#include "data_port.h"
+
+#include <algorithm>
+
+#include "tusb.h"
+#include "usb_descriptors.h"
+#include "feud.h"
+#include "frame_scheduler.h"
+#include "clock_governor.h"
+#include "system_monitor.h"
+
+DataPort& DataPort::instance() {
+    static DataPort port;
+    if (!port.initialized) {
+        port.initialized = true;
+        port.init();
+    }
+    return port;
+}
+
+void DataPort::init() {
+    rx_length = 0;
+}
+
+bool DataPort::is_connected() const {
+    return tud_cdc_n_connected(USB_CDC_DATA);
+}
+
+void DataPort::update() {
+    receive();
+    
+    if (telemetry_interval_ms > 0) {
+        const uint32_t now = to_ms_since_boot(get_absolute_time());
+        if (now - last_telemetry_ms >= telemetry_interval_ms) {
+            last_telemetry_ms = now;
+            send_telemetry();
+        }
+    }
+}
+
+void DataPort::receive() {
+    const auto payload_length = [this]() -> size_t { return rx_packet[2] | (rx_packet[3] << 8); };
+    
+    while (tud_cdc_n_available(USB_CDC_DATA) > 0) {
+        if (rx_length == 0) {
+            uint8_t byte = 0;
+            tud_cdc_n_read(USB_CDC_DATA, &byte, 1);
+            if (byte == SYNC) {
+                rx_packet[rx_length++] = byte;
+            } else {
+                bad_packets++;
+            }
+            continue;
+        }
+        
+        // Read straight into the packet: the rest of the header, then the payload
+        const size_t target = (rx_length < HEADER_SIZE) ? HEADER_SIZE : HEADER_SIZE + payload_length();
+        rx_length += tud_cdc_n_read(USB_CDC_DATA, &rx_packet[rx_length], target - rx_length);
+        if (rx_length < HEADER_SIZE) continue;
+        
+        if (payload_length() > MAX_PAYLOAD) {
+            bad_packets++;
+            rx_length = 0;
+        } else if (rx_length == HEADER_SIZE + payload_length()) {
+            packets_received++;
+            handle_packet((PacketType)rx_packet[1], &rx_packet[HEADER_SIZE], rx_length - HEADER_SIZE);
+            rx_length = 0;
+        }
+    }
+}
+
+void DataPort::handle_packet(PacketType type, const uint8_t* payload, size_t length) {
+    switch (type) {
+        case PacketType::FRAME:
+            if (!handle_frame(payload, length)) {
+                bad_packets++;
+            }
+            break;
+    
+        case PacketType::TELEMETRY_RATE:
+            if (length != 2) {
+                bad_packets++;
+                break;
+            }
+            telemetry_interval_ms = payload[0] | (payload[1] << 8);
+            if (telemetry_interval_ms > 0) {
+                telemetry_interval_ms = std::max(telemetry_interval_ms, MIN_TELEMETRY_MS);
+                send_telemetry();
+                last_telemetry_ms = to_ms_since_boot(get_absolute_time());
+            }
+            break;
+    
+        default:
+            bad_packets++;
+            break;
+    }
+}
+
+bool DataPort::handle_frame(const uint8_t* payload, size_t length) {
+    if (length < 3 || (length - 3) % 3 != 0) return false;
+    
+    const uint strip = payload[0];
+    const uint start = payload[1] | (payload[2] << 8);
+    const uint count = (length - 3) / 3;
+    if (strip >= NUM_STRIPS || start + count > LEDS_PER_STRIP) return false;
+    
+    // Same effect as led_set per LED: the base layer holds the frame
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    const uint8_t* rgb = payload + 3;
+    for (uint i = 0; i < count; i++, rgb += 3) {
+        ws2812.set_led(strip, start + i, rgb[0], rgb[1], rgb[2]);
+    }
+    if (ws2812.get_animation_mode() != AnimationMode::STATIC) {
+        ws2812.set_animation(AnimationMode::STATIC);
+    }
+    
+    frames_received++;
+    return true;
+}
+
+void DataPort::send_telemetry() {
+    const FeudSnapshot game = Feud::instance().snapshot();
+    const FrameStats frame_stats = FrameScheduler::instance().get_stats();
+    const ClockGovernor& governor = ClockGovernor::instance();
+    
+    Telemetry telemetry{};
+    telemetry.time_us = time_us_64();
+    telemetry.time_remaining = game.time_remaining;
+    telemetry.pressed_mask = game.pressed_mask;
+    telemetry.frames = frame_stats.frames;
+    telemetry.missed = frame_stats.missed;
+    telemetry.render_us = WS2812Controller::instance().get_last_render_us();
+    telemetry.worst_iteration_us = SystemMonitor::instance().get_worst_iteration_us();
+    telemetry.sys_khz = governor.get_sys_hz() / 1000;
+    telemetry.frames_received = frames_received;
+    telemetry.bad_packets = bad_packets;
+    telemetry.state = (uint8_t)game.state;
+    telemetry.clock_level = (uint8_t)governor.get_level();
+    
+    if (send_packet(PacketType::TELEMETRY, &telemetry, sizeof(telemetry))) {
+        telemetry_sent++;
+    }
+}
+
+bool DataPort::send_packet(PacketType type, const void* payload, size_t length) {
+    if (!is_connected()) return false;
+    
+    // Never block the loop on the data port: a packet goes out whole or not at all
+    if (tud_cdc_n_write_available(USB_CDC_DATA) < HEADER_SIZE + length) {
+        tx_dropped++;
+        return false;
+    }
+    
+    const uint8_t header[HEADER_SIZE] = {SYNC, (uint8_t)type, (uint8_t)length, (uint8_t)(length >> 8)};
+    tud_cdc_n_write(USB_CDC_DATA, header, sizeof(header));
+    tud_cdc_n_write(USB_CDC_DATA, payload, length);
+    tud_cdc_n_write_flush(USB_CDC_DATA);
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef DATA_PORT_H
+#define DATA_PORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "pico/stdlib.h"
+#include "ws2812_controller.h"
+
+// Binary protocol on the second CDC port. Every packet, in either
+// direction, is
+//
+//   0xA5, type, payload length (16-bit little endian), payload
+//
+// Bytes outside a packet are skipped up to the next 0xA5, so a host can
+// resynchronise by sending a few zero bytes. Multi-byte fields are little
+// endian.
+enum class PacketType : uint8_t {
+    // Host to device
+    FRAME = 0x01,           // strip (8), first LED (16), then r, g, b per LED
+    TELEMETRY_RATE = 0x02,  // interval ms (16), 0 stops
+    
+    // Device to host
+    TELEMETRY = 0x81,       // Telemetry
+};
+
+// Periodic device state; field order keeps every member naturally aligned
+struct Telemetry {
+    uint64_t time_us;           // time_us_64() when sent
+    uint32_t time_remaining;    // Round timer, seconds
+    uint32_t pressed_mask;      // Bit per player
+    uint32_t frames;            // Frames rendered (frame scheduler)
+    uint32_t missed;            // Frame ticks missed
+    uint32_t render_us;         // Last frame render time
+    uint32_t worst_iteration_us;
+    uint32_t sys_khz;
+    uint32_t frames_received;   // FRAME packets applied
+    uint32_t bad_packets;       // Packets rejected, bytes skipped resynchronising
+    uint8_t state;              // GameState
+    uint8_t clock_level;        // ClockLevel
+    uint8_t reserved[2];
+};
+static_assert(sizeof(Telemetry) == 48);
+
+// The data port: pixel frames in, telemetry out. Handled from the main
+// loop after USBSerial::update() has run the USB stack.
+class DataPort {
+ private:
+    bool initialized = false;
+    
+    static constexpr uint8_t SYNC = 0xA5;
+    static constexpr size_t HEADER_SIZE = 4;
+    static constexpr size_t MAX_PAYLOAD = 3 + 3 * LEDS_PER_STRIP;
+    static constexpr uint32_t MIN_TELEMETRY_MS = 10;
+    
+    // Packet being received; complete once HEADER_SIZE + its length
+    std::array<uint8_t, HEADER_SIZE + MAX_PAYLOAD> rx_packet{};
+    size_t rx_length = 0;
+    
+    uint32_t telemetry_interval_ms = 0;
+    uint32_t last_telemetry_ms = 0;
+    
+    // Statistics
+    uint32_t packets_received = 0;
+    uint32_t frames_received = 0;
+    uint32_t bad_packets = 0;
+    uint32_t telemetry_sent = 0;
+    uint32_t tx_dropped = 0;    // Packets not sent because the host was not reading
+    
+    void init();
+    void receive();
+    void handle_packet(PacketType type, const uint8_t* payload, size_t length);
+    bool handle_frame(const uint8_t* payload, size_t length);
+    void send_telemetry();
+
+ public:
+    static DataPort& instance();
+    
+    void update();
+    
+    // Drops the packet if the host is not reading fast enough
+    bool send_packet(PacketType type, const void* payload, size_t length);
+    
+    bool is_connected() const;
+    uint32_t get_telemetry_interval_ms() const { return telemetry_interval_ms; }
+    uint32_t get_packets_received() const { return packets_received; }
+    uint32_t get_frames_received() const { return frames_received; }
+    uint32_t get_bad_packets() const { return bad_packets; }
+    uint32_t get_telemetry_sent() const { return telemetry_sent; }
+    uint32_t get_tx_dropped() const { return tx_dropped; }
+};
+
+#endif  // DATA_PORT_H
@@ -0,0 +1,200 @@
+#include "effect_vm.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "hot_path.h"
+
+// Raw opcodes as uploaded
+enum : uint8_t {
+    RAW_LDI = 0x01, RAW_MOV = 0x02,
+    RAW_ADD = 0x10, RAW_SLT = 0x1C,
+    RAW_ADDI = 0x20, RAW_ANDI = 0x24,
+    RAW_SIN = 0x30, RAW_HUE = 0x31, RAW_SCL = 0x32,
+    RAW_JMP = 0x40, RAW_JZ = 0x41, RAW_JNZ = 0x42,
+    RAW_OUT = 0x50
+};
+
+EffectVM& EffectVM::instance() {
+    static EffectVM vm;
+    if (!vm.initialized) {
+        vm.initialized = true;
+        vm.init();
+    }
+    return vm;
+}
+
+void EffectVM::init() {
+    for (uint i = 0; i < 256; i++) {
+        sine_table[i] = 128 + (int)lrintf(127.0f * sinf(i * 2.0f * (float)M_PI / 256.0f));
+        hue_table[i] = rainbow_color(i);
+    }
+}
+
+bool EffectVM::append(const uint8_t* bytes, size_t length) {
+    if (staging_length + length > staging.size()) return false;
+    
+    std::copy(bytes, bytes + length, staging.begin() + staging_length);
+    staging_length += length;
+    return true;
+}
+
+bool EffectVM::commit(uint slot) {
+    if (slot >= MAX_EFFECTS) return fail(0, "invalid slot");
+    
+    EffectProgram program;
+    if (!decode(staging.data(), staging_length, program)) return false;
+    
+    programs[slot] = program;
+    staging_length = 0;
+    return true;
+}
+
+void EffectVM::clear(uint slot) {
+    if (slot < MAX_EFFECTS) {
+        programs[slot] = EffectProgram{};
+    }
+}
+
+bool EffectVM::fail(uint instruction, const char* reason) {
+    error_instruction = instruction;
+    error_reason = reason;
+    return false;
+}
+
+bool EffectVM::decode(const uint8_t* bytes, size_t length, EffectProgram& program) {
+    if (length == 0 || length % EFFECT_INSTRUCTION_BYTES != 0) return fail(0, "length not a multiple of 4");
+    
+    const uint count = length / EFFECT_INSTRUCTION_BYTES;
+    if (count > MAX_EFFECT_INSTRUCTIONS) return fail(0, "program too long");
+    
+    for (uint i = 0; i < count; i++) {
+        const uint8_t* raw = bytes + i * EFFECT_INSTRUCTION_BYTES;
+        const uint8_t op = raw[0];
+        EffectInstruction& ins = program.code[i];
+        ins.d = raw[1];
+        ins.a = raw[2];
+        ins.b = raw[3];
+        ins.imm = 0;
+        
+        // Which operand bytes name registers
+        bool d_reg = true;
+        bool a_reg = true;
+        bool b_reg = false;
+        
+        if (op == RAW_LDI) {
+            ins.op = EffectOp::LDI;
+            ins.imm = (int16_t)(raw[2] | (raw[3] << 8));
+            a_reg = false;
+        } else if (op == RAW_MOV) {
+            ins.op = EffectOp::MOV;
+        } else if (op >= RAW_ADD && op <= RAW_SLT) {
+            ins.op = (EffectOp)((uint)EffectOp::ADD + (op - RAW_ADD));
+            b_reg = true;
+        } else if (op >= RAW_ADDI && op <= RAW_ANDI) {
+            ins.op = (EffectOp)((uint)EffectOp::ADDI + (op - RAW_ADDI));
+            const bool is_signed = (ins.op == EffectOp::ADDI || ins.op == EffectOp::MULI);
+            ins.imm = is_signed ? (int8_t)raw[3] : raw[3];
+            if ((ins.op == EffectOp::SHLI || ins.op == EffectOp::SHRI) && ins.imm > 31) {
+                return fail(i, "shift out of range");
+            }
+        } else if (op == RAW_SIN) {
+            ins.op = EffectOp::SIN;
+        } else if (op == RAW_HUE) {
+            ins.op = EffectOp::HUE;
+            if (ins.d > EFFECT_REGISTERS - 3) return fail(i, "hue needs d..d+2");
+        } else if (op == RAW_SCL) {
+            ins.op = EffectOp::SCL;
+            b_reg = true;
+        } else if (op >= RAW_JMP && op <= RAW_JNZ) {
+            ins.op = (EffectOp)((uint)EffectOp::JMP + (op - RAW_JMP));
+            d_reg = (op != RAW_JMP);
+            a_reg = false;
+            
+            // Forward only, so every program terminates
+            const uint offset = (op == RAW_JMP) ? raw[1] : raw[2];
+            ins.imm = i + 1 + offset;
+            if (ins.imm >= (int32_t)count) return fail(i, "jump past end");
+        } else if (op == RAW_OUT) {
+            ins.op = EffectOp::OUT;
+            b_reg = true;
+        } else {
+            return fail(i, "unknown opcode");
+        }
+        
+        if ((d_reg && ins.d >= EFFECT_REGISTERS) || (a_reg && ins.a >= EFFECT_REGISTERS) ||
+            (b_reg && ins.b >= EFFECT_REGISTERS)) {
+            return fail(i, "register out of range");
+        }
+        
+        // Unused operands read r0, so the interpreter can load a and b unconditionally
+        if (!d_reg) ins.d = 0;
+        if (!a_reg) ins.a = 0;
+        if (!b_reg) ins.b = 0;
+    }
+    
+    if (program.code[count - 1].op != EffectOp::OUT) return fail(count - 1, "last instruction must be OUT");
+    
+    program.length = count;
+    return true;
+}
+
+static inline uint8_t clamp_channel(int32_t value) {
+    return std::clamp<int32_t>(value, 0, 255);
+}
+
+void HOT_PATH_FUNC(EffectVM::render)(uint slot, const EffectInputs& inputs, RGB* pixels, uint count) const {
+    const EffectInstruction* code = programs[slot].code.data();
+    
+    // Arithmetic wraps as on the hardware; done unsigned to stay defined
+    for (uint index = 0; index < count; index++) {
+        int32_t r[EFFECT_REGISTERS] = {(int32_t)index, (int32_t)inputs.strip, (int32_t)inputs.time_ms,
+                                       (int32_t)inputs.timer_remaining, (int32_t)inputs.count};
+        
+        const EffectInstruction* pc = code;
+        for (;;) {
+            const EffectInstruction& ins = *pc++;
+            const int32_t a = r[ins.a];
+            const int32_t b = r[ins.b];
+            
+            switch (ins.op) {
+                case EffectOp::LDI: r[ins.d] = ins.imm; break;
+                case EffectOp::MOV: r[ins.d] = a; break;
+                case EffectOp::ADD: r[ins.d] = (uint32_t)a + (uint32_t)b; break;
+                case EffectOp::SUB: r[ins.d] = (uint32_t)a - (uint32_t)b; break;
+                case EffectOp::MUL: r[ins.d] = (uint32_t)a * (uint32_t)b; break;
+                case EffectOp::DIV: r[ins.d] = (b == 0) ? 0 : (b == -1) ? -(uint32_t)a : a / b; break;
+                case EffectOp::MOD: r[ins.d] = (b == 0 || b == -1) ? 0 : a % b; break;
+                case EffectOp::AND: r[ins.d] = a & b; break;
+                case EffectOp::OR:  r[ins.d] = a | b; break;
+                case EffectOp::XOR: r[ins.d] = a ^ b; break;
+                case EffectOp::SHL: r[ins.d] = (uint32_t)a << (b & 31); break;
+                case EffectOp::SHR: r[ins.d] = a >> (b & 31); break;
+                case EffectOp::MIN: r[ins.d] = std::min(a, b); break;
+                case EffectOp::MAX: r[ins.d] = std::max(a, b); break;
+                case EffectOp::SLT: r[ins.d] = a < b; break;
+                case EffectOp::ADDI: r[ins.d] = (uint32_t)a + (uint32_t)ins.imm; break;
+                case EffectOp::MULI: r[ins.d] = (uint32_t)a * (uint32_t)ins.imm; break;
+                case EffectOp::SHLI: r[ins.d] = (uint32_t)a << ins.imm; break;
+                case EffectOp::SHRI: r[ins.d] = a >> ins.imm; break;
+                case EffectOp::ANDI: r[ins.d] = a & ins.imm; break;
+                case EffectOp::SIN: r[ins.d] = sine_table[a & 0xFF]; break;
+                case EffectOp::HUE: {
+                    const RGB& color = hue_table[a & 0xFF];
+                    r[ins.d] = color.r;
+                    r[ins.d + 1] = color.g;
+                    r[ins.d + 2] = color.b;
+                    break;
+                }
+                case EffectOp::SCL: r[ins.d] = ((int64_t)a * b) / 255; break;
+                case EffectOp::JMP: pc = code + ins.imm; break;
+                case EffectOp::JZ: if (r[ins.d] == 0) pc = code + ins.imm; break;
+                case EffectOp::JNZ: if (r[ins.d] != 0) pc = code + ins.imm; break;
+                case EffectOp::OUT:
+                    pixels[index] = RGB(clamp_channel(r[ins.d]), clamp_channel(a), clamp_channel(b));
+                    goto next_pixel;
+            }
+        }
+    next_pixel:;
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef EFFECT_VM_H
+#define EFFECT_VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "pico/stdlib.h"
+#include "ws2812_controller.h"
+
+// Uploaded effect programs: a small register machine evaluated once per
+// pixel per frame. Instructions are 4 bytes, [op, d, a, b]:
+//
+//   0x01 LDI  d, imm16      d = (int16_t)(a | b << 8)
+//   0x02 MOV  d, a
+//   0x10-0x1C d = a <op> b  ADD SUB MUL DIV MOD AND OR XOR SHL SHR MIN MAX SLT
+//   0x20-0x24 d = a <op> b  ADDI MULI (b signed) SHLI SHRI ANDI (b unsigned)
+//   0x30 SIN  d, a          d = sine table[a & 255], 0..255 centred on 128
+//   0x31 HUE  d, a          d, d+1, d+2 = rainbow r, g, b of hue a & 255
+//   0x32 SCL  d, a, b       d = a * b / 255
+//   0x40 JMP  off           skip the next off instructions
+//   0x41 JZ   d, off        skip the next off instructions if d == 0
+//   0x42 JNZ  d, off
+//   0x50 OUT  d, a, b       pixel = (d, a, b) clamped to 0..255, done
+//
+// On entry r0 = pixel index within the layer range, r1 = strip,
+// r2 = ms since the animation started, r3 = game timer seconds left,
+// r4 = range length; r5-r15 are zero. Division by zero gives zero.
+//
+// Programs are validated when committed: registers in range, jumps only
+// forward and inside the program, the last instruction an OUT. Every path
+// therefore ends at an OUT within MAX_EFFECT_INSTRUCTIONS steps, and the
+// interpreter runs the pre-decoded form without any checks.
+constexpr uint MAX_EFFECTS = 4;
+constexpr uint MAX_EFFECT_INSTRUCTIONS = 64;
+constexpr uint EFFECT_INSTRUCTION_BYTES = 4;
+constexpr uint EFFECT_REGISTERS = 16;
+
+// Decoded operation; dense so the dispatch switch becomes a jump table
+enum class EffectOp : uint8_t {
+    LDI, MOV,
+    ADD, SUB, MUL, DIV, MOD, AND, OR, XOR, SHL, SHR, MIN, MAX, SLT,
+    ADDI, MULI, SHLI, SHRI, ANDI,
+    SIN, HUE, SCL,
+    JMP, JZ, JNZ,
+    OUT
+};
+
+struct EffectInstruction {
+    EffectOp op;
+    uint8_t d;
+    uint8_t a;
+    uint8_t b;
+    int32_t imm;    // Immediate, or absolute jump target
+};
+
+struct EffectProgram {
+    std::array<EffectInstruction, MAX_EFFECT_INSTRUCTIONS> code{};
+    uint8_t length = 0;     // 0: empty slot
+};
+
+// Per-frame inputs, shared by every pixel of a layer
+struct EffectInputs {
+    uint32_t strip;
+    uint32_t time_ms;
+    uint32_t timer_remaining;
+    uint32_t count;
+};
+
+class EffectVM {
+ private:
+    bool initialized = false;
+    
+    std::array<EffectProgram, MAX_EFFECTS> programs{};
+    
+    // Upload staging, filled by append() and decoded by commit()
+    std::array<uint8_t, MAX_EFFECT_INSTRUCTIONS * EFFECT_INSTRUCTION_BYTES> staging{};
+    size_t staging_length = 0;
+    
+    std::array<uint8_t, 256> sine_table{};
+    std::array<RGB, 256> hue_table{};
+    
+    // Last commit failure
+    uint error_instruction = 0;
+    const char* error_reason = nullptr;
+    
+    void init();
+    bool fail(uint instruction, const char* reason);
+    bool decode(const uint8_t* bytes, size_t length, EffectProgram& program);
+
+ public:
+    static EffectVM& instance();
+    
+    // Upload: begin() clears the staging buffer, append() adds bytes,
+    // commit() validates and decodes them into a slot
+    void begin() { staging_length = 0; }
+    bool append(const uint8_t* bytes, size_t length);
+    bool commit(uint slot);
+    void clear(uint slot);
+    
+    // Evaluates slot for pixels[0..count), r0 running from 0
+    void render(uint slot, const EffectInputs& inputs, RGB* pixels, uint count) const;
+    
+    bool is_loaded(uint slot) const { return slot < MAX_EFFECTS && programs[slot].length > 0; }
+    uint get_length(uint slot) const { return programs[slot].length; }
+    size_t get_staging_length() const { return staging_length; }
+    uint get_error_instruction() const { return error_instruction; }
+    const char* get_error_reason() const { return error_reason; }
+};
+
+#endif  // EFFECT_VM_H
@@ -1,9 +1,13 @@
 #include "feud.h"
 #include "usb_serial.h"
 #include "ws2812_controller.h"
+#include "hot_path.h"
+#include "audio_output.h"
+#include "player_lamps.h"
 
 #include <stdint.h>
 #include <stdio.h>
+#include <atomic>
 #include <cstring>
 
 #include "hardware/clocks.h"
@@ -11,10 +15,41 @@
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
 #include "hardware/timer.h"
 
-// Static instance pointer for callbacks
+static_assert(MAX_PLAYERS <= MAX_LAMPS);
+
+// Static instance pointers for callbacks; instance() itself is in flash
 static Feud* feud_instance = nullptr;
+static AudioOutput* audio_output = nullptr;
+
+// time_us_64() is in flash, so the button IRQ reads the timer itself. The
+// latched TIMELR/TIMEHR pair would corrupt a main-loop read in progress;
+// the raw registers are read instead, retrying if the low word wrapped.
+static inline __attribute__((always_inline)) uint64_t irq_time_us() {
+#if PICO_ON_DEVICE
+    uint32_t high = timer_hw->timerawh;
+    while (true) {
+        const uint32_t low = timer_hw->timerawl;
+        const uint32_t next_high = timer_hw->timerawh;
+        if (next_high == high) return ((uint64_t)high << 32) | low;
+        high = next_high;
+    }
+#else
+    return time_us_64();
+#endif
+}
+
+// Pins the firmware drives itself, which no player may take over
+static constexpr uint32_t RESERVED_PINS =
+    (1u << WS2812_PIN_STRIP_0) | (1u << WS2812_PIN_STRIP_1) |
+    (1u << APA102_CLOCK_PIN_STRIP_0) | (1u << APA102_CLOCK_PIN_STRIP_1) |
+    (1u << LEVEL_SHIFTER_ENABLE_PIN) | (1u << AUDIO_PIN)
+#ifdef PICO_DEFAULT_WS2812_PIN
+    | (1u << PICO_DEFAULT_WS2812_PIN)
+#endif
+    ;
 
 Feud& Feud::instance() {
     static Feud feud;
@@ -27,55 +62,98 @@ Feud& Feud::instance() {
 }
 
 void Feud::init() {
+    audio_output = &AudioOutput::instance();
+    gpio_set_irq_callback(&gpio_callback);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+    
+    configure_players(DEFAULT_PLAYERS.data(), DEFAULT_PLAYERS.size());
+}
+
+bool Feud::configure_players(const PlayerConfig* configs, uint count) {
+    if (count == 0 || count > MAX_PLAYERS) return false;
+    
+    // Every button and lamp needs its own pin, clear of the strips and audio
+    uint32_t used = RESERVED_PINS;
+    for (uint i = 0; i < count; i++) {
+        const uint button = configs[i].button_pin;
+        const uint lamp = configs[i].led_pin;
+        if (button >= NUM_BANK0_GPIOS || lamp >= NUM_BANK0_GPIOS || button == lamp) {
+            return false;
+        }
+        const uint32_t pins = (1u << button) | (1u << lamp);
+        if (used & pins) return false;
+        used |= pins;
+    }
+    
+    std::array<uint, MAX_PLAYERS> lamp_pins{};
+    for (uint i = 0; i < count; i++) {
+        lamp_pins[i] = configs[i].led_pin;
+    }
+    if (!PlayerLamps::instance().can_drive(lamp_pins.data(), count)) {
+        return false;
+    }
+    
+    btn_gpio_deinit();
+    
+    player_count = count;
+    for (uint i = 0; i < count; i++) {
+        players[i] = configs[i];
+    }
+    clear_presses();
+    last_button_us.fill(0);
+    
     btn_gpio_init();
     led_init();
+    publish();
+    return true;
 }
 
 void Feud::btn_gpio_init() {
-    // Initialize button pins as inputs with pull-up resistors
-    gpio_init(PLAYER_A_BUTTON_PIN);
-    gpio_set_dir(PLAYER_A_BUTTON_PIN, GPIO_IN);
-    gpio_pull_up(PLAYER_A_BUTTON_PIN);
-    
-    gpio_init(PLAYER_B_BUTTON_PIN);
-    gpio_set_dir(PLAYER_B_BUTTON_PIN, GPIO_IN);
-    gpio_pull_up(PLAYER_B_BUTTON_PIN);
-    
-    // Set up interrupts for button presses (falling edge)
-    // Clear any existing interrupts first
-    gpio_set_irq_enabled(PLAYER_A_BUTTON_PIN, GPIO_IRQ_EDGE_RISE, false);
-    gpio_set_irq_enabled(PLAYER_B_BUTTON_PIN, GPIO_IRQ_EDGE_RISE, false);
-    gpio_set_irq_enabled(PLAYER_A_BUTTON_PIN, GPIO_IRQ_EDGE_FALL, false);
-    gpio_set_irq_enabled(PLAYER_B_BUTTON_PIN, GPIO_IRQ_EDGE_FALL, false);
-    
-    // Set up interrupt callbacks
-    gpio_set_irq_callback(&gpio_callback);
-    irq_set_enabled(IO_IRQ_BANK0, true);
+    button_mask = 0;
     
-    // Enable interrupts for both pins
-    gpio_set_irq_enabled(PLAYER_A_BUTTON_PIN, GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(PLAYER_B_BUTTON_PIN, GPIO_IRQ_EDGE_FALL, true);
+    for (uint i = 0; i < player_count; i++) {
+        const uint pin = players[i].button_pin;
+        
+        // Initialize button pins as inputs with pull-up resistors
+        gpio_init(pin);
+        gpio_set_dir(pin, GPIO_IN);
+        gpio_pull_up(pin);
+        gpio_set_input_hysteresis_enabled(pin, true);
+        
+        // Set up interrupts for button presses (falling edge)
+        // Clear any existing interrupts first
+        gpio_set_irq_enabled(pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        gpio_set_irq_enabled(pin, GPIO_IRQ_EDGE_FALL, true);
+        
+        button_mask |= 1u << pin;
+    }
+}
 
-    gpio_set_input_hysteresis_enabled(PLAYER_A_BUTTON_PIN, true);
-    gpio_set_input_hysteresis_enabled(PLAYER_B_BUTTON_PIN, true);
+void Feud::btn_gpio_deinit() {
+    for (uint i = 0; i < player_count; i++) {
+        gpio_set_irq_enabled(players[i].button_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        gpio_deinit(players[i].button_pin);
+    }
+    button_mask = 0;
+    PlayerLamps::instance().release();
 }
 
 void Feud::led_init() {
-    // Initialize LED pins as outputs
-    gpio_init(PLAYER_A_LED_PIN);
-    gpio_set_dir(PLAYER_A_LED_PIN, GPIO_OUT);
-    gpio_put(PLAYER_A_LED_PIN, 0);
-    
-    gpio_init(PLAYER_B_LED_PIN);
-    gpio_set_dir(PLAYER_B_LED_PIN, GPIO_OUT);
-    gpio_put(PLAYER_B_LED_PIN, 0);
-    
+    // Lamps go to PWM; configure_players() has checked that they fit
+    std::array<uint, MAX_PLAYERS> lamp_pins{};
+    for (uint i = 0; i < player_count; i++) {
+        lamp_pins[i] = players[i].led_pin;
+    }
+    PlayerLamps::instance().configure(lamp_pins.data(), player_count);
+    lamps_dirty = true;
 }
 
 void Feud::update() {
+    announce_presses();
     update_timer();
     update_buttons();
     update_leds();
+    publish();
     
     // Send status updates at regular intervals when game is active
     uint32_t current_time = to_ms_since_boot(get_absolute_time());
@@ -96,6 +174,7 @@ void Feud::update_timer() {
             time_remaining = 0;
             timer_expired_naturally = true;
             current_state = GameState::IDLE;
+            AudioOutput::instance().play(Sound::TIMER_EXPIRED);
             
             // Set all LED strips to red when timer expires
             WS2812Controller& ws2812 = WS2812Controller::instance();
@@ -116,105 +195,239 @@ void Feud::update_buttons() {
 }
 
 void Feud::update_leds() {
-    switch (current_state) {
-        case GameState::IDLE:
-            gpio_put(PLAYER_A_LED_PIN, 0);
-            gpio_put(PLAYER_B_LED_PIN, 0);
-            break;
-            
+    // Patterns run in PWM and DMA hardware, so only state transitions need work
+    const GameState state = current_state;
+    if (state == lamp_state && !lamps_dirty) return;
+    lamp_state = state;
+    lamps_dirty = false;
+    
+    PlayerLamps& lamps = PlayerLamps::instance();
+    switch (state) {
         case GameState::TIMER_RUNNING:
-            // Flash both LEDs to indicate timer is running
-            {
-                uint32_t current_time = to_ms_since_boot(get_absolute_time());
-                bool flash_on = (current_time / 250) % 2; // Flash every 250ms
-                gpio_put(PLAYER_A_LED_PIN, flash_on ? 1 : 0);
-                gpio_put(PLAYER_B_LED_PIN, flash_on ? 1 : 0);
-            }
+            // Flash all lamps to indicate timer is running
+            lamps.show(LampPattern::BLINK, 500); // Flash every 250ms
             break;
             
         case GameState::TIMER_PAUSED:
-            // Slow flash to indicate paused
-            {
-                uint32_t current_time = to_ms_since_boot(get_absolute_time());
-                bool flash_on = (current_time / 1000) % 2; // Flash every 1 second
-                gpio_put(PLAYER_A_LED_PIN, flash_on ? 1 : 0);
-                gpio_put(PLAYER_B_LED_PIN, flash_on ? 1 : 0);
-            }
+            // Slow pulse to indicate paused
+            lamps.show(LampPattern::BREATHE, 2000);
             break;
             
-        case GameState::PLAYER_A_PRESSED:
-            gpio_put(PLAYER_A_LED_PIN, 0);
-            gpio_put(PLAYER_B_LED_PIN, 0);
-            break;
-            
-        case GameState::PLAYER_B_PRESSED:
-            gpio_put(PLAYER_A_LED_PIN, 0);
-            gpio_put(PLAYER_B_LED_PIN, 0);
+        case GameState::IDLE:
+        case GameState::PLAYER_PRESSED:
+            lamps.show(LampPattern::OFF, 0);
             break;
     }
 }
 
+void Feud::announce_presses() {
+    if (!status_pending) return;
+    status_pending = false;
+    
+    // A command may have ended the round since the press
+    if (current_state != GameState::PLAYER_PRESSED) {
+        round_stopped = false;
+        return;
+    }
+    
+    if (round_stopped) {
+        round_stopped = false;
+        
+        // The clock stopped at the press, not when the loop got here
+        const uint32_t elapsed = (uint32_t)(stop_time_us / 1000) - timer_start_time;
+        paused_time_remaining = (elapsed < timer_duration_ms) ? (timer_duration_ms - elapsed) / 1000 : 0;
+        time_remaining = paused_time_remaining;
+        
+        // Light the strip of each winning player
+        WS2812Controller& ws = WS2812Controller::instance();
+        ws.set_animation(AnimationMode::STATIC);
+        for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+            ws.set_strip(strip, (winner_mask & (1u << strip)) ? Colors::YELLOW : Colors::BLACK);
+        }
+        ws.update(true);
+    }
+    
+    send_status_directly();
+}
+
 void Feud::send_status_directly() {
     USBSerial& serial = USBSerial::instance();
     
-    char status_msg[128];
-    snprintf(status_msg, sizeof(status_msg), 
-             "status: timer=%lu playera=%d playerb=%d active=%c expired=%d\n",
-             time_remaining,
-             player_a_pressed ? 1 : 0,
-             player_b_pressed ? 1 : 0,
-             get_active_player(),
-             timer_expired_naturally ? 1 : 0);
+    // Every state change is announced here, so this is also where it is published
+    publish();
+    const FeudSnapshot status = snapshot();
+    
+    char order[3 * MAX_PLAYERS + 1];
+    status.format_press_order(order, sizeof(order));
     
-    serial.send_data(reinterpret_cast<const uint8_t*>(status_msg), strlen(status_msg));
+    const uint32_t start = time_us_32();
+    serial.append("status: timer=", status.time_remaining,
+                  " playera=", status.is_player_pressed(0),
+                  " playerb=", status.is_player_pressed(1),
+                  " active=", status.active_player(),
+                  " expired=", status.timer_expired,
+                  " pressed=", Hex{status.pressed_mask, 2},
+                  " order=", order,
+                  " tie=", status.is_tie());
+    
+    // Device timestamps (time_us_64) of this line and of each press rank, for
+    // placing events on the host timeline after time_sync
+    serial.append(" t=", time_us_64(), " press_t=");
+    if (status.press_count == 0) {
+        serial.append('-');
+    }
+    for (uint i = 0; i < status.press_count; i++) {
+        const PressRecord& press = status.press_order[i];
+        if (i == 0 || press.rank != status.press_order[i - 1].rank) {
+            serial.append(i ? "," : "", press.time_us);
+        }
+    }
+    
+    // Console link health, to spot a host that is falling behind
+    const UsbStats& link = serial.get_stats();
+    serial.append(" usb_lost=", link.rx_truncated + link.held_dropped + link.tx_timeouts,
+                  " usb_stall_max=", link.tx_stall_max_us,
+                  " host_idle_ms=", (time_us_64() - serial.get_line_rx_us()) / 1000);
+    serial.print('\n');
+    status_emit_us = time_us_32() - start;
     
     // Clear the expired flag after sending
     timer_expired_naturally = false;
 }
 
-void Feud::gpio_callback(uint gpio, uint32_t events) {
-    if (!feud_instance || !(events & GPIO_IRQ_EDGE_FALL)) return;
-
-    const uint32_t now = to_ms_since_boot(get_absolute_time());
-
-    if (gpio == PLAYER_A_BUTTON_PIN) {
-        uint32_t& last = feud_instance->last_button_a_time;
-        if ((now - last) < DEBOUNCE_MS) return;
-        last = now;
-
-        //printf("Button A\n");
+void HOT_PATH_FUNC(Feud::publish)() {
+    const auto capture = [this]() {
+        FeudSnapshot snapshot;
+        snapshot.state = current_state;
+        snapshot.time_remaining = time_remaining;
+        snapshot.pressed_mask = pressed_mask;
+        snapshot.winner_mask = winner_mask;
+        snapshot.timer_expired = timer_expired_naturally;
+        snapshot.player_count = player_count;
+        snapshot.press_count = press_count;
+        std::copy(press_order.begin(), press_order.begin() + press_count, snapshot.press_order.begin());
+        return snapshot;
+    };
+    
+    // Nothing that publishes can preempt the ISR
+    if (__get_current_exception()) {
+        isr_publishes = isr_publishes + 1;
+        write_snapshot(capture());
+        return;
+    }
+    
+    // The ISR may have changed the live fields mid-capture, or overwritten
+    // part of the copy; either way it counted, and the publish is redone
+    uint32_t isr_count;
+    do {
+        isr_count = isr_publishes;
+        write_snapshot(capture());
+    } while (isr_publishes != isr_count);
+}
 
-        if (feud_instance->current_state == GameState::TIMER_RUNNING) {
-            feud_instance->pause_timer(true);
-            feud_instance->player_a_pressed = true;
-            feud_instance->current_state = GameState::PLAYER_A_PRESSED;
+void HOT_PATH_FUNC(Feud::write_snapshot)(const FeudSnapshot& snapshot) {
+    // Stays odd, rather than flipping back to even, when nested inside a
+    // main-loop write, so the ISR can read its own publish straight after
+    const uint32_t writing = publish_sequence | 1;
+    publish_sequence = writing;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    published = snapshot;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    publish_sequence = writing + 1;
+}
 
-            WS2812Controller& ws = WS2812Controller::instance();
-            ws.set_animation(AnimationMode::STATIC);
-            ws.set_strip(0, Colors::YELLOW);
-            ws.set_strip(1, Colors::BLACK);
-            ws.update(true);
+FeudSnapshot Feud::snapshot() const {
+    FeudSnapshot copy;
+    uint32_t sequence;
+    do {
+        sequence = publish_sequence;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        copy = published;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } while ((sequence & 1) || publish_sequence != sequence);
+    return copy;
+}
 
-            feud_instance->send_status_directly();
+int HOT_PATH_FUNC(Feud::find_player)(uint gpio) const {
+    for (uint i = 0; i < player_count; i++) {
+        if (players[i].button_pin == gpio) {
+            return i;
         }
+    }
+    return -1;
+}
 
-    } else if (gpio == PLAYER_B_BUTTON_PIN) {
-        uint32_t& last = feud_instance->last_button_b_time;
-        if ((now - last) < DEBOUNCE_MS) return;
-        last = now;
-
-        if (feud_instance->current_state == GameState::TIMER_RUNNING) {
-            feud_instance->pause_timer(true);
-            feud_instance->player_b_pressed = true;
-            feud_instance->current_state = GameState::PLAYER_B_PRESSED;
+uint32_t HOT_PATH_FUNC(Feud::players_low)(uint32_t bank_snapshot) const {
+    uint32_t low = 0;
+    for (uint i = 0; i < player_count; i++) {
+        if (!(bank_snapshot & (1u << players[i].button_pin))) {
+            low |= 1u << i;
+        }
+    }
+    return low;
+}
 
-            WS2812Controller& ws = WS2812Controller::instance();
-            ws.set_animation(AnimationMode::STATIC);
-            ws.set_strip(0, Colors::BLACK);
-            ws.set_strip(1, Colors::YELLOW);
-            ws.update(true);
+void HOT_PATH_FUNC(Feud::record_presses)(uint32_t bank_snapshot, uint edge_player, uint64_t now_us) {
+    // Every player whose button reads low in the same bank sample pressed
+    // simultaneously; the edge that raised the IRQ counts even if it has
+    // already bounced back high. A button held down since the presses were
+    // cleared is no press, and only counts again once it has been released.
+    const uint32_t low = players_low(bank_snapshot);
+    held_mask &= low & ~(1u << edge_player);
+    uint32_t group = (low & ~held_mask) | (1u << edge_player);
+    group &= ~pressed_mask;
+    if (!group) return;
+    
+    const uint8_t rank = next_rank++;
+    for (uint i = 0; i < player_count; i++) {
+        if (group & (1u << i)) {
+            press_order[press_count++] = PressRecord{(uint8_t)i, rank, now_us};
+            // Tied players are debounced along with the edge player
+            last_button_us[i] = (uint32_t)now_us;
+        }
+    }
+    pressed_mask |= group;
+    if (rank == 0) {
+        winner_mask = group;
+    }
+}
 
-            feud_instance->send_status_directly();
+void HOT_PATH_FUNC(Feud::gpio_callback)(uint gpio, uint32_t events) {
+    if (!feud_instance || !(events & GPIO_IRQ_EDGE_FALL)) return;
+    
+    // Sample the whole bank once, before anything else, so that presses
+    // landing in the same sample are ties rather than IRQ dispatch order
+    const uint32_t bank_snapshot = gpio_get_all();
+    const uint64_t now = irq_time_us();
+    
+    Feud& feud = *feud_instance;
+    const int player = feud.find_player(gpio);
+    if (player < 0) return;
+    
+    uint32_t& last = feud.last_button_us[player];
+    if (((uint32_t)now - last) < DEBOUNCE_US) return;
+    last = (uint32_t)now;
+    
+    // Only the press is latched here. The strips, the timer and the status
+    // line belong to the main loop, which wakes from __wfe() on this IRQ;
+    // rendering or printing here would race it for the interpolator and
+    // the USB buffers.
+    if (feud.current_state == GameState::TIMER_RUNNING) {
+        // Sound first: the buzz starts within microseconds of the press
+        audio_output->play(Sound::BUZZER);
+        feud.record_presses(bank_snapshot, player, now);
+        feud.current_state = GameState::PLAYER_PRESSED;
+        feud.stop_time_us = now;
+        feud.round_stopped = true;
+        feud.status_pending = true;
+        feud.publish();
+    } else if (feud.current_state == GameState::PLAYER_PRESSED) {
+        // Late presses extend the ranked order
+        const uint previous = feud.press_count;
+        feud.record_presses(bank_snapshot, player, now);
+        if (feud.press_count != previous) {
+            feud.status_pending = true;
+            feud.publish();
         }
     }
 }
@@ -223,9 +436,8 @@ void Feud::start_timer(uint32_t duration_seconds) {
     timer_duration_ms = duration_seconds * 1000;
     timer_start_time = to_ms_since_boot(get_absolute_time());
     time_remaining = duration_seconds;
+    clear_presses();
     current_state = GameState::TIMER_RUNNING;
-    player_a_pressed = false;
-    player_b_pressed = false;
     timer_expired_naturally = false; // Reset expiration flag
     
     // Set all LED strips to black when timer starts
@@ -244,7 +456,7 @@ void Feud::stop_timer() {
     time_remaining = 0;
     paused_time_remaining = 0;
     timer_expired_naturally = false; // Ensure manual stop doesn't trigger expiration
-
+    
     WS2812Controller& ws = WS2812Controller::instance();
     ws.set_animation(AnimationMode::STATIC);
     ws.set_strip(0, Colors::BLACK);
@@ -255,7 +467,7 @@ void Feud::stop_timer() {
     send_status_directly();
 }
 
-void Feud::pause_timer(bool noupdate) {
+void Feud::pause_timer() {
     if (current_state == GameState::TIMER_RUNNING) {
         // Calculate remaining time when pausing
         uint32_t current_time = to_ms_since_boot(get_absolute_time());
@@ -269,36 +481,32 @@ void Feud::pause_timer(bool noupdate) {
         
         current_state = GameState::TIMER_PAUSED;
         time_remaining = paused_time_remaining;
-
-        if (!noupdate) {
-            WS2812Controller& ws = WS2812Controller::instance();
-            ws.set_animation(AnimationMode::STATIC);
-            ws.set_strip(0, Colors::BLACK);
-            ws.set_strip(1, Colors::BLACK);
-            ws.update();
-            // Send status update
-            send_status_directly();
-        }
+        
+        WS2812Controller& ws = WS2812Controller::instance();
+        ws.set_animation(AnimationMode::STATIC);
+        ws.set_strip(0, Colors::BLACK);
+        ws.set_strip(1, Colors::BLACK);
+        ws.update();
+        // Send status update
+        send_status_directly();
     }
 }
 
 void Feud::resume_timer() {
     // Allow resume from TIMER_PAUSED or PLAYER_PRESSED states
     if ((current_state == GameState::TIMER_PAUSED || 
-         current_state == GameState::PLAYER_A_PRESSED ||
-         current_state == GameState::PLAYER_B_PRESSED) && 
+         current_state == GameState::PLAYER_PRESSED) && 
         paused_time_remaining > 0) {
         
         // Resume with remaining time
         timer_duration_ms = paused_time_remaining * 1000;
         timer_start_time = to_ms_since_boot(get_absolute_time());
         time_remaining = paused_time_remaining;
-        current_state = GameState::TIMER_RUNNING;
         
         // Clear player pressed states when resuming
-        player_a_pressed = false;
-        player_b_pressed = false;
-
+        clear_presses();
+        current_state = GameState::TIMER_RUNNING;
+    
         WS2812Controller& ws = WS2812Controller::instance();
         ws.set_animation(AnimationMode::STATIC);
         ws.set_strip(0, Colors::BLACK);
@@ -316,8 +524,7 @@ void Feud::reset_game() {
     timer_start_time = 0;
     time_remaining = 0;
     paused_time_remaining = 0;
-    player_a_pressed = false;
-    player_b_pressed = false;
+    clear_presses();
     timer_expired_naturally = false; // Reset expiration flag
     
     // Clear all LED strips on reset and restart rainbow animation
@@ -338,16 +545,14 @@ void Feud::force_reset() {
     timer_start_time = 0;
     time_remaining = 0;
     paused_time_remaining = 0;
-    player_a_pressed = false;
-    player_b_pressed = false;
+    clear_presses();
     timer_expired_naturally = false; // Reset expiration flag
     last_status_time = 0;
-    last_button_a_time = 0;
-    last_button_b_time = 0;
+    last_button_us.fill(0);
     
-    // Reset all LEDs
-    gpio_put(PLAYER_A_LED_PIN, 0);
-    gpio_put(PLAYER_B_LED_PIN, 0);
+    // Reset all lamps; they are PWM outputs, so this goes through PlayerLamps
+    PlayerLamps::instance().show(LampPattern::OFF, 0);
+    lamp_state = current_state;
     
     // Clear all LED strips on force reset and restart rainbow animation
     WS2812Controller& ws2812 = WS2812Controller::instance();
@@ -360,13 +565,81 @@ void Feud::force_reset() {
     send_status_directly();
 }
 
-char Feud::get_active_player() const {
-    switch (current_state) {
-        case GameState::PLAYER_A_PRESSED:
-            return 'A';
-        case GameState::PLAYER_B_PRESSED:
-            return 'B';
-        default:
-            return 'N'; // None
+bool Feud::restore_state(GameState state, uint32_t remaining_seconds, uint32_t pressed, uint32_t winners) {
+    // Only a round in progress is worth restoring; it comes back paused
+    // (or with its buzz) so the host decides when play continues
+    if ((state != GameState::TIMER_RUNNING && state != GameState::TIMER_PAUSED &&
+         state != GameState::PLAYER_PRESSED) || remaining_seconds == 0) {
+        return false;
+    }
+    
+    clear_presses();
+    paused_time_remaining = remaining_seconds;
+    time_remaining = remaining_seconds;
+    current_state = GameState::TIMER_PAUSED;
+    
+    WS2812Controller& ws = WS2812Controller::instance();
+    ws.set_animation(AnimationMode::STATIC);
+    ws.clear_all();
+    
+    if (state == GameState::PLAYER_PRESSED && (winners & pressed)) {
+        // The exact order is lost; winners keep the first rank
+        const uint32_t all = (1u << player_count) - 1;
+        for (uint rank = 0; rank < 2; rank++) {
+            const uint32_t group = (rank == 0 ? winners : pressed & ~winners) & all;
+            for (uint i = 0; i < player_count; i++) {
+                if (group & (1u << i)) {
+                    press_order[press_count++] = PressRecord{(uint8_t)i, (uint8_t)next_rank, 0};
+                }
+            }
+            if (group) next_rank++;
+        }
+        pressed_mask = pressed & all;
+        winner_mask = winners & all;
+        current_state = GameState::PLAYER_PRESSED;
+        
+        for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+            ws.set_strip(strip, (winner_mask & (1u << strip)) ? Colors::YELLOW : Colors::BLACK);
+        }
+    }
+    
+    ws.update(true);
+    send_status_directly();
+    return true;
+}
+
+void Feud::clear_presses() {
+    press_count = 0;
+    next_rank = 0;
+    pressed_mask = 0;
+    winner_mask = 0;
+    
+    // Whoever is holding their button now has to let go to buzz in
+    held_mask = players_low(gpio_get_all());
+}
+
+char FeudSnapshot::active_player() const {
+    if (state != GameState::PLAYER_PRESSED || press_count == 0) {
+        return 'N'; // None
+    }
+    // Ties report the lowest-numbered winner; see is_tie()
+    return player_letter(press_order[0].player);
+}
+
+size_t FeudSnapshot::format_press_order(char* buffer, size_t size) const {
+    // Ranks are separated by ',' and tied players joined by '=', e.g. "B=C,A"
+    size_t pos = 0;
+    if (size == 0) return 0;
+    
+    for (uint i = 0; i < press_count && pos + 2 < size; i++) {
+        if (i > 0) {
+            buffer[pos++] = (press_order[i].rank == press_order[i - 1].rank) ? '=' : ',';
+        }
+        buffer[pos++] = player_letter(press_order[i].player);
+    }
+    if (pos == 0 && size > 1) {
+        buffer[pos++] = '-';
     }
+    buffer[pos] = '\0';
+    return pos;
 }
@@ -9,18 +9,58 @@
 #include "hardware/timer.h"
 #include "pico/stdlib.h"
 
-// GPIO pin definitions
-constexpr uint PLAYER_A_BUTTON_PIN = 15;
-constexpr uint PLAYER_B_BUTTON_PIN = 14;
-constexpr uint PLAYER_A_LED_PIN = 11;
-constexpr uint PLAYER_B_LED_PIN = 10;  // Pin 8 is used for level shifter enable
+// Player podiums: a button (active low) and a lamp per player
+constexpr uint MAX_PLAYERS = 8;
+constexpr uint8_t NO_PLAYER = 0xFF;
+
+struct PlayerConfig {
+    uint button_pin;
+    uint led_pin;
+};
+
+// GPIO pin definitions for the default two-player setup
+constexpr std::array<PlayerConfig, 2> DEFAULT_PLAYERS{{
+    {15, 11},  // Player A
+    {14, 10}   // Player B, pin 8 is used for level shifter enable
+}};
+
+constexpr char player_letter(uint player) { return 'A' + player; }
+
+// Longest round the timer runs
+constexpr uint32_t MAX_TIMER_SECONDS = 300;
 
 enum class GameState {
     IDLE,
     TIMER_RUNNING,
     TIMER_PAUSED,
-    PLAYER_A_PRESSED,
-    PLAYER_B_PRESSED
+    PLAYER_PRESSED
+};
+
+// One entry of the ranked press order. Players pressed in the same GPIO
+// bank sample share a rank.
+struct PressRecord {
+    uint8_t player;
+    uint8_t rank;
+    uint64_t time_us;   // Device time_us_64() of the bank sample
+};
+
+// Consistent copy of the game state, published by Feud whenever it
+// changes. Readers in the main loop take one with Feud::snapshot() rather
+// than reading several getters, which the GPIO ISR can change in between.
+struct FeudSnapshot {
+    GameState state = GameState::IDLE;
+    uint32_t time_remaining = 0;
+    uint32_t pressed_mask = 0;
+    uint32_t winner_mask = 0;
+    bool timer_expired = false;     // Expired naturally since the last status line
+    uint8_t player_count = 0;
+    uint8_t press_count = 0;
+    std::array<PressRecord, MAX_PLAYERS> press_order{};
+    
+    bool is_player_pressed(uint player) const { return pressed_mask & (1u << player); }
+    bool is_tie() const { return (winner_mask & (winner_mask - 1)) != 0; }
+    char active_player() const;
+    size_t format_press_order(char* buffer, size_t size) const;
 };
 
 enum class MessageType {
@@ -74,19 +114,44 @@ class Feud {
     bool initialized = false;
     GameState current_state = GameState::IDLE;
     uint32_t timer_duration_ms = 0;
+    uint32_t default_duration_s = 0;  // Used by start_timer without a duration, 0 = none
     uint32_t timer_start_time = 0;
     uint32_t time_remaining = 0;
     uint32_t paused_time_remaining = 0; // Time remaining when paused
-    bool player_a_pressed = false;
-    bool player_b_pressed = false;
     bool timer_expired_naturally = false; // Flag to track natural timer expiration
+    uint32_t status_emit_us = 0;          // Format and send time of the last status line
+    GameState lamp_state = GameState::IDLE; // State the lamp pattern was last set for
+    bool lamps_dirty = true;              // Pattern needs setting regardless of lamp_state
+    
+    // Seqlock over the published snapshot: odd while a copy is being
+    // written. The ISR may publish in the middle of a main-loop publish,
+    // so the main loop repeats its publish if isr_publishes moved.
+    FeudSnapshot published;
+    volatile uint32_t publish_sequence = 0;
+    volatile uint32_t isr_publishes = 0;
+    
+    // Player configuration
+    std::array<PlayerConfig, MAX_PLAYERS> players{};
+    uint player_count = 0;
+    uint32_t button_mask = 0;  // GPIO bank mask of all button pins
+    
+    // Press tracking, in ranked order
+    std::array<PressRecord, MAX_PLAYERS> press_order{};
+    uint press_count = 0;
+    uint8_t next_rank = 0;
+    uint32_t pressed_mask = 0;  // Bit per player
+    uint32_t winner_mask = 0;   // Players sharing the first rank
+    uint32_t held_mask = 0;     // Buttons already down when presses were cleared, until released
     
-volatile bool debounce_a_pending = false;
-volatile bool debounce_b_pending = false;
-    // Debouncing
-    uint32_t last_button_a_time = 0;
-    uint32_t last_button_b_time = 0;
-    static constexpr uint32_t DEBOUNCE_MS = 25;
+    // Debouncing, on the low word of the microsecond timer
+    std::array<uint32_t, MAX_PLAYERS> last_button_us{};
+    static constexpr uint32_t DEBOUNCE_US = 25000;
+    
+    // Set by the ISR, which only latches presses; the main loop stops the
+    // round and sends the status line (announce_presses)
+    volatile bool status_pending = false;
+    volatile bool round_stopped = false;  // The first press of a running round
+    volatile uint64_t stop_time_us = 0;   // When it landed
     
     // Message buffer for asynchronous communication
     CircularBuffer<GameMessage, 8> message_buffer;
@@ -94,12 +159,20 @@ volatile bool debounce_b_pending = false;
     static constexpr uint32_t STATUS_INTERVAL_MS = 50;
     
     void btn_gpio_init();
+    void btn_gpio_deinit();
     void led_init();
     void init();
     void update_timer();
     void update_buttons();
     void update_leds();
+    void announce_presses();
     void send_status_directly();
+    void publish();
+    void write_snapshot(const FeudSnapshot& snapshot);
+    void clear_presses();
+    void record_presses(uint32_t bank_snapshot, uint edge_player, uint64_t now_us);
+    uint32_t players_low(uint32_t bank_snapshot) const;
+    int find_player(uint gpio) const;
     
     static void gpio_callback(uint gpio, uint32_t events);
     
@@ -110,17 +183,32 @@ volatile bool debounce_b_pending = false;
     // Game control methods
     void start_timer(uint32_t duration_seconds);
     void stop_timer();
-    void pause_timer(bool noupdate = false);
+    void pause_timer();
     void resume_timer();
     void reset_game();
     void force_reset(); // Complete system reset
+    bool restore_state(GameState state, uint32_t remaining_seconds, uint32_t pressed, uint32_t winners);
+    
+    void set_default_duration(uint32_t seconds) { default_duration_s = seconds; }
+    uint32_t get_default_duration() const { return default_duration_s; }
+    
+    // Player configuration
+    bool configure_players(const PlayerConfig* configs, uint count);
+    uint get_player_count() const { return player_count; }
+    const PlayerConfig& get_player_config(uint player) const { return players[player]; }
+    
+    // Consistent copy of the published state; never blocks the ISR, retries
+    // if it publishes during the copy
+    FeudSnapshot snapshot() const;
     
-    // Status getters
+    // Status getters, each a single field
     GameState get_state() const { return current_state; }
     uint32_t get_time_remaining() const { return time_remaining; }
-    bool is_player_a_pressed() const { return player_a_pressed; }
-    bool is_player_b_pressed() const { return player_b_pressed; }
-    char get_active_player() const;
+    bool is_player_pressed(uint player) const { return pressed_mask & (1u << player); }
+    uint32_t get_pressed_mask() const { return pressed_mask; }
+    uint32_t get_winner_mask() const { return winner_mask; }
+    bool is_tie() const { return (winner_mask & (winner_mask - 1)) != 0; }
+    uint32_t get_status_emit_us() const { return status_emit_us; }
 };
 
 #endif  // FEUD_H
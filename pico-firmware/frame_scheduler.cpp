@@ -0,0 +1,104 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hot_path.h"
+
+FrameScheduler& FrameScheduler::instance() {
+    static FrameScheduler scheduler;
+    if (!scheduler.initialized) {
+        scheduler.initialized = true;
+        scheduler.init();
+    }
+    return scheduler;
+}
+
+void FrameScheduler::init() {
+    start_timer();
+}
+
+void FrameScheduler::start_timer() {
+    period_us = 1000000 / rate_hz;
+    last_tick_timestamp = time_us_32();
+    
+    // Negative delay schedules ticks relative to the previous target time,
+    // so the rate doesn't drift with callback latency
+    add_repeating_timer_us(-(int64_t)period_us, timer_callback, this, &timer);
+}
+
+bool HOT_PATH_FUNC(FrameScheduler::timer_callback)(repeating_timer_t* rt) {
+    FrameScheduler* self = static_cast<FrameScheduler*>(rt->user_data);
+    const uint32_t now = time_us_32();
+    
+    const uint32_t interval = now - self->last_tick_timestamp;
+    const uint32_t jitter = (interval > self->period_us) ? interval - self->period_us : self->period_us - interval;
+    self->last_tick_timestamp = now;
+    if (jitter > self->tick_jitter_max_us) {
+        self->tick_jitter_max_us = jitter;
+    }
+    
+    if (self->frame_pending) {
+        self->missed_frames = self->missed_frames + 1;
+    }
+    
+    self->tick_count = self->tick_count + 1;
+    self->tick_time_us = self->tick_time_us + self->period_us;
+    self->tick_timestamp = now;
+    self->frame_pending = true;
+    
+    // Wake the main loop
+    __sev();
+    return true;
+}
+
+bool FrameScheduler::consume_frame() {
+    if (!frame_pending) return false;
+    
+    uint32_t irq_state = save_and_disable_interrupts();
+    frame_pending = false;
+    frame_count = tick_count;
+    frame_time_us = tick_time_us;
+    uint32_t tick_at = tick_timestamp;
+    restore_interrupts(irq_state);
+    
+    const uint32_t latency = time_us_32() - tick_at;
+    latency_max_us = std::max(latency_max_us, latency);
+    latency_sum_us += latency;
+    rendered_frames++;
+    
+    return true;
+}
+
+void FrameScheduler::set_rate(uint32_t hz) {
+    hz = std::clamp(hz, MIN_FRAME_RATE_HZ, MAX_FRAME_RATE_HZ);
+    if (hz == rate_hz) return;
+    
+    cancel_repeating_timer(&timer);
+    rate_hz = hz;
+    start_timer();
+    reset_stats();
+}
+
+FrameStats FrameScheduler::get_stats() const {
+    FrameStats stats;
+    stats.rate_hz = rate_hz;
+    stats.frames = rendered_frames;
+    stats.missed = missed_frames;
+    stats.tick_jitter_max_us = tick_jitter_max_us;
+    stats.latency_avg_us = rendered_frames ? (uint32_t)(latency_sum_us / rendered_frames) : 0;
+    stats.latency_max_us = latency_max_us;
+    return stats;
+}
+
+void FrameScheduler::reset_stats() {
+    uint32_t irq_state = save_and_disable_interrupts();
+    missed_frames = 0;
+    tick_jitter_max_us = 0;
+    restore_interrupts(irq_state);
+    
+    rendered_frames = 0;
+    latency_max_us = 0;
+    latency_sum_us = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "pico/time.h"
+
+constexpr uint32_t DEFAULT_FRAME_RATE_HZ = 60;
+constexpr uint32_t MIN_FRAME_RATE_HZ = 10;
+constexpr uint32_t MAX_FRAME_RATE_HZ = 1000;  // Clocked strips; WS2812 strips are held to their wire time
+
+struct FrameStats {
+    uint32_t rate_hz;
+    uint32_t frames;            // Frames rendered since the last reset
+    uint32_t missed;            // Ticks that arrived before the previous frame was rendered
+    uint32_t tick_jitter_max_us;  // Worst deviation of the timer tick from its period
+    uint32_t latency_avg_us;    // Tick to render start
+    uint32_t latency_max_us;
+};
+
+// Paces frames from a repeating hardware timer. Each tick advances a
+// monotonic frame counter and a nominal frame time that animations use as
+// their time base, so animation steps are exact regardless of loop timing.
+class FrameScheduler {
+ private:
+    bool initialized = false;
+    repeating_timer_t timer{};
+    uint32_t rate_hz = DEFAULT_FRAME_RATE_HZ;
+    uint32_t period_us = 1000000 / DEFAULT_FRAME_RATE_HZ;
+    
+    // Written by the timer callback
+    volatile uint32_t tick_count = 0;
+    volatile uint64_t tick_time_us = 0;     // Nominal time of the latest tick
+    volatile uint32_t tick_timestamp = 0;   // time_us_32() at the latest tick
+    volatile bool frame_pending = false;
+    uint32_t last_tick_timestamp = 0;
+    
+    // Snapshot of the frame being rendered, owned by the main loop
+    uint32_t frame_count = 0;
+    uint64_t frame_time_us = 0;
+    
+    // Statistics
+    volatile uint32_t missed_frames = 0;
+    volatile uint32_t tick_jitter_max_us = 0;
+    uint32_t rendered_frames = 0;
+    uint32_t latency_max_us = 0;
+    uint64_t latency_sum_us = 0;
+    
+    void init();
+    void start_timer();
+    
+    static bool timer_callback(repeating_timer_t* rt);
+    
+ public:
+    static FrameScheduler& instance();
+    
+    // Returns true once per timer tick and latches the frame's time base
+    bool consume_frame();
+    
+    void set_rate(uint32_t hz);
+    uint32_t get_rate() const { return rate_hz; }
+    
+    // Time base for the frame being rendered
+    uint32_t get_frame() const { return frame_count; }
+    uint32_t get_frame_time_ms() const { return frame_time_us / 1000; }
+    
+    FrameStats get_stats() const;
+    void reset_stats();
+};
+
+#endif  // FRAME_SCHEDULER_H
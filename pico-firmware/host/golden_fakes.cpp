@@ -0,0 +1,50 @@
+#include "host_fakes.h"
+
+#include "clock_governor.h"
+#include "feud.h"
+#include "frame_scheduler.h"
+
+// Singletons for the golden-frame harness: frames run on a virtual clock
+// that the harness advances, and the game never leaves IDLE.
+
+static uint64_t virtual_time_us = 0;
+
+void host_set_time_us(uint64_t time_us) {
+    virtual_time_us = time_us;
+    FrameScheduler::instance().consume_frame();
+}
+
+// Every call is a tick: frames are driven by the harness, not a timer
+FrameScheduler& FrameScheduler::instance() {
+    static FrameScheduler scheduler;
+    return scheduler;
+}
+
+bool FrameScheduler::consume_frame() {
+    frame_count++;
+    frame_time_us = virtual_time_us;
+    return true;
+}
+
+void FrameScheduler::set_rate(uint32_t hz) {
+    rate_hz = hz;
+    period_us = 1000000 / hz;
+}
+
+FrameStats FrameScheduler::get_stats() const {
+    return FrameStats{rate_hz, frame_count, 0, 0, 0, 0};
+}
+
+void FrameScheduler::reset_stats() {}
+
+ClockGovernor& ClockGovernor::instance() {
+    static ClockGovernor governor;
+    return governor;
+}
+
+void ClockGovernor::report_render([[maybe_unused]] uint32_t render_us, [[maybe_unused]] uint32_t period_us) {}
+
+Feud& Feud::instance() {
+    static Feud feud;
+    return feud;
+}
@@ -0,0 +1,462 @@
+// Golden-frame regression harness for the LED pipeline.
+//
+// Runs WS2812Controller on the host against a virtual clock, captures the
+// DMA words each strip would clock out, decodes them back to RGB with the
+// strip's wire format and hashes every frame. The hashes are compared with
+// host/golden/frames.txt, so a change to an animation, the compositor or
+// an encode kernel shows up as the first frame that differs.
+//
+//   golden_frames                      compare against the golden hashes
+//   golden_frames --update             rewrite the golden hashes
+//   golden_frames --save-frames f      also write the decoded frames to f
+//   golden_frames --frames f --tolerance n
+//                                      compare with frames saved from a
+//                                      reference build, allowing each
+//                                      channel to differ by up to n
+//   golden_frames --repeat n           time n extra runs per scenario
+//   golden_frames --only name          run one scenario
+//
+// Each scenario is timed over its update() calls; the best run is
+// reported in microseconds per frame.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "host_fakes.h"
+#include "effect_vm.h"
+#include "frame_scheduler.h"
+#include "ws2812_controller.h"
+
+#ifndef GOLDEN_FILE
+#define GOLDEN_FILE "golden/frames.txt"
+#endif
+
+using Frame = std::array<std::array<RGB, LEDS_PER_STRIP>, NUM_STRIPS>;
+
+struct Scenario {
+    const char* name;
+    uint frames;
+    void (*setup)(WS2812Controller& ws);
+};
+
+static void setup_gradient(WS2812Controller& ws) {
+    ws.set_gradient(0, 0, LEDS_PER_STRIP, RGB(255, 0, 0), RGB(0, 0, 255));
+    ws.set_gradient(1, 5, 50, RGB(0, 255, 32), RGB(255, 255, 255));
+}
+
+static void setup_rainbow(WS2812Controller& ws) {
+    ws.set_animation(AnimationMode::RAINBOW, 20);
+}
+
+static void setup_chase(WS2812Controller& ws) {
+    ws.set_animation_colors(RGB(255, 128, 0), RGB(0, 0, 64));
+    ws.set_animation(AnimationMode::CHASE, 40);
+}
+
+static void setup_pulse(WS2812Controller& ws) {
+    ws.set_animation_colors(RGB(0, 128, 255), RGB(0, 0, 0));
+    ws.set_animation(AnimationMode::PULSE, 15);
+}
+
+static void setup_fade(WS2812Controller& ws) {
+    ws.set_animation_colors(RGB(255, 0, 0), RGB(0, 0, 255));
+    ws.set_animation(AnimationMode::FADE, 10);
+}
+
+static void setup_sparkle(WS2812Controller& ws) {
+    ws.set_animation_colors(RGB(255, 255, 255), RGB(0, 0, 0));
+    ws.set_animation(AnimationMode::SPARKLE, 30);
+}
+
+static void setup_dither(WS2812Controller& ws) {
+    ws.set_all(RGB(37, 91, 200));
+    ws.set_brightness(0.27f);
+    ws.set_dithering(true);
+}
+
+static void setup_layers(WS2812Controller& ws) {
+    ws.set_animation(AnimationMode::RAINBOW, 20);
+    
+    ws.set_layer_colors(1, RGB(255, 0, 0), RGB(0, 0, 0));
+    ws.set_layer_animation(1, AnimationMode::PULSE, 25);
+    ws.set_layer_blend(1, BlendMode::ADD, 160);
+    ws.set_layer_mask(1, 0b10, 10, 30);
+    
+    ws.set_layer_fill(2, RGB(128, 128, 255));
+    ws.set_layer_enabled(2, true);
+    ws.set_layer_blend(2, BlendMode::MULTIPLY, 200);
+    ws.set_layer_mask(2, 0b01, 0, 20);
+}
+
+static void setup_zones(WS2812Controller& ws) {
+    const ZoneRange left[] = {{0, 0, 30}};
+    const ZoneRange ring[] = {{0, 30, 30}, {1, 0, 60}};
+    ws.define_zone("left", left, std::size(left));
+    ws.define_zone("ring", ring, std::size(ring));
+    
+    ws.set_zone_gradient(ws.find_zone("left"), 0, 30, RGB(255, 255, 0), RGB(0, 64, 0));
+    ws.set_zone_animation(ws.find_zone("ring"), AnimationMode::CHASE, 30, RGB(0, 255, 255), RGB(32, 0, 0));
+}
+
+static void setup_effect(WS2812Controller& ws) {
+    // Hue from position and time: HUE(r0 * 4 + r2 / 8)
+    static constexpr uint8_t program[] = {
+        0x23, 6, 2, 3,      // SHRI r6, r2, 3
+        0x21, 5, 0, 4,      // MULI r5, r0, 4
+        0x10, 5, 5, 6,      // ADD  r5, r5, r6
+        0x31, 7, 5, 0,      // HUE  r7, r5
+        0x50, 7, 8, 9,      // OUT  r7, r8, r9
+    };
+    EffectVM& vm = EffectVM::instance();
+    vm.begin();
+    vm.append(program, sizeof(program));
+    vm.commit(0);
+    
+    ws.set_layer_effect(1, 0);
+}
+
+// One wide chip at a time (MAX_WIDE_STRIPS); the decoded frames match
+// the WS2812 strip beside it either way
+static void setup_chips(WS2812Controller& ws) {
+    ws.set_strip_chip(0, LedChip::SK6812_RGBW);
+    ws.set_animation(AnimationMode::RAINBOW, 20);
+    ws.set_brightness(0.8f);
+}
+
+static void setup_apa102(WS2812Controller& ws) {
+    ws.set_strip_chip(1, LedChip::APA102);
+    ws.set_animation(AnimationMode::RAINBOW, 20);
+    ws.set_brightness(0.8f);
+}
+
+static constexpr Scenario scenarios[] = {
+    {"gradient", 2, setup_gradient},
+    {"rainbow", 90, setup_rainbow},
+    {"chase", 90, setup_chase},
+    {"pulse", 90, setup_pulse},
+    {"fade", 90, setup_fade},
+    {"sparkle", 60, setup_sparkle},
+    {"dither", 64, setup_dither},
+    {"layers", 60, setup_layers},
+    {"zones", 60, setup_zones},
+    {"effect", 60, setup_effect},
+    {"chips", 30, setup_chips},
+    {"apa102", 30, setup_apa102},
+};
+
+// Back to a blank, static, full-brightness WS2812 show
+static void reset_controller(WS2812Controller& ws) {
+    host_set_time_us(0);
+    
+    for (uint layer = 1; layer < MAX_LAYERS; layer++) {
+        ws.set_layer_enabled(layer, false);
+        ws.set_layer_blend(layer, BlendMode::NORMAL, 255);
+        ws.set_layer_mask(layer, (1u << NUM_STRIPS) - 1);
+    }
+    for (uint zone = 0; zone < MAX_ZONES; zone++) {
+        if (ws.is_zone_valid(zone)) {
+            ws.delete_zone(ws.get_zone(zone).get_name());
+        }
+    }
+    for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+        ws.set_strip_chip(strip, LedChip::WS2812);
+    }
+    
+    ws.set_animation(AnimationMode::STATIC);
+    ws.set_dithering(false);
+    ws.set_brightness(1.0f);
+    ws.clear_all();
+    ws.seed_random(1);
+}
+
+// Decodes a strip's wire words; false if they are not a well-formed frame
+static bool decode_strip(LedChip chip, const CapturedFrame& captured, std::array<RGB, LEDS_PER_STRIP>& pixels) {
+    const uint32_t* w = captured.words;
+    if (!w) return false;
+    
+    switch (chip) {
+        // Single-wire chips send the buffer bytes in memory order
+        case LedChip::WS2812: {
+            if (captured.count != (LEDS_PER_STRIP * 3 + 3) / 4) return false;
+            const uint8_t* grb = reinterpret_cast<const uint8_t*>(w);
+            for (uint i = 0; i < LEDS_PER_STRIP; i++, grb += 3) {
+                pixels[i] = RGB(grb[1], grb[0], grb[2]);
+            }
+            return true;
+        }
+        
+        case LedChip::SK6812_RGBW: {
+            if (captured.count != LEDS_PER_STRIP) return false;
+            const uint8_t* grbw = reinterpret_cast<const uint8_t*>(w);
+            for (uint i = 0; i < LEDS_PER_STRIP; i++, grbw += 4) {
+                const uint white = grbw[3];
+                const uint g = grbw[0] + white;
+                const uint r = grbw[1] + white;
+                const uint b = grbw[2] + white;
+                if (r > 255 || g > 255 || b > 255) return false;
+                pixels[i] = RGB(r, g, b);
+            }
+            return true;
+        }
+        
+        case LedChip::APA102: {
+            const uint end_words = (LEDS_PER_STRIP + 63) / 64;
+            if (captured.count != 1 + LEDS_PER_STRIP + end_words || w[0] != 0) return false;
+            for (uint i = 0; i < LEDS_PER_STRIP; i++) {
+                const uint32_t word = w[1 + i];
+                if ((word >> 24) != 0xFF) return false;
+                pixels[i] = RGB(word & 0xFF, (word >> 8) & 0xFF, (word >> 16) & 0xFF);
+            }
+            for (uint i = 0; i < end_words; i++) {
+                if (w[1 + LEDS_PER_STRIP + i] != 0xFFFFFFFF) return false;
+            }
+            return true;
+        }
+    
+        default:
+            return false;
+    }
+}
+
+// FNV-1a over every decoded channel
+static uint64_t hash_frame(const Frame& frame) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const auto& strip : frame) {
+        for (const RGB& p : strip) {
+            for (uint8_t c : {p.r, p.g, p.b}) {
+                hash = (hash ^ c) * 0x100000001b3ull;
+            }
+        }
+    }
+    return hash;
+}
+
+struct RunResult {
+    std::vector<Frame> frames;
+    bool well_formed = true;
+    double us_per_frame = 0;
+};
+
+static RunResult run_scenario(const Scenario& scenario) {
+    WS2812Controller& ws = WS2812Controller::instance();
+    RunResult result;
+    
+    reset_controller(ws);
+    scenario.setup(ws);
+    
+    std::chrono::nanoseconds update_time{0};
+    uint64_t time_us = 0;
+    for (uint f = 0; f < scenario.frames; f++) {
+        host_set_time_us(time_us);
+    
+        const auto start = std::chrono::steady_clock::now();
+        ws.update();
+        update_time += std::chrono::steady_clock::now() - start;
+    
+        Frame frame{};
+        for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+            if (!decode_strip(ws.get_strip_chip(strip), host_strip_frame(strip), frame[strip])) {
+                result.well_formed = false;
+            }
+        }
+        result.frames.push_back(frame);
+    
+        time_us += 1000000 / FrameScheduler::instance().get_rate();
+    }
+    
+    result.us_per_frame = std::chrono::duration<double, std::micro>(update_time).count() / scenario.frames;
+    return result;
+}
+
+using GoldenHashes = std::map<std::string, std::vector<uint64_t>>;
+
+static bool load_golden(const char* path, GoldenHashes& golden) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        char name[64];
+        unsigned frame = 0;
+        unsigned long long hash = 0;
+        if (line[0] == '#' || sscanf(line, "%63s %u %llx", name, &frame, &hash) != 3) continue;
+    
+        std::vector<uint64_t>& hashes = golden[name];
+        if (hashes.size() <= frame) hashes.resize(frame + 1);
+        hashes[frame] = hash;
+    }
+    fclose(file);
+    return true;
+}
+
+// Reference frames: per scenario, the name, frame count and raw pixels
+static bool save_frames(FILE* file, const Scenario& scenario, const RunResult& result) {
+    const uint32_t count = result.frames.size();
+    char name[32] = {};
+    strncpy(name, scenario.name, sizeof(name) - 1);
+    return fwrite(name, sizeof(name), 1, file) == 1 && fwrite(&count, sizeof(count), 1, file) == 1 &&
+           fwrite(result.frames.data(), sizeof(Frame), count, file) == count;
+}
+
+static bool load_frames(const char* path, std::map<std::string, std::vector<Frame>>& reference) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    
+    char name[32];
+    uint32_t count = 0;
+    while (fread(name, sizeof(name), 1, file) == 1 && fread(&count, sizeof(count), 1, file) == 1) {
+        std::vector<Frame>& frames = reference[std::string(name, strnlen(name, sizeof(name)))];
+        frames.resize(count);
+        if (fread(frames.data(), sizeof(Frame), count, file) != count) break;
+    }
+    fclose(file);
+    return true;
+}
+
+static int max_channel_difference(const Frame& a, const Frame& b) {
+    int worst = 0;
+    for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+        for (uint i = 0; i < LEDS_PER_STRIP; i++) {
+            const RGB& p = a[strip][i];
+            const RGB& q = b[strip][i];
+            worst = std::max({worst, abs(p.r - q.r), abs(p.g - q.g), abs(p.b - q.b)});
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    const char* golden_path = GOLDEN_FILE;
+    const char* save_path = nullptr;
+    const char* frames_path = nullptr;
+    const char* only = nullptr;
+    bool update = false;
+    int tolerance = 0;
+    int repeat = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (strcmp(argv[i], "--golden") == 0 && has_value) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "--save-frames") == 0 && has_value) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            frames_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            tolerance = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && has_value) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--only") == 0 && has_value) {
+            only = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--update] [--golden file] [--save-frames file] "
+                            "[--frames file --tolerance n] [--repeat n] [--only scenario]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    GoldenHashes golden;
+    std::map<std::string, std::vector<Frame>> reference;
+    if (frames_path) {
+        if (!load_frames(frames_path, reference)) {
+            fprintf(stderr, "cannot read %s\n", frames_path);
+            return 2;
+        }
+    } else if (!update && !load_golden(golden_path, golden)) {
+        fprintf(stderr, "cannot read %s; run with --update to create it\n", golden_path);
+        return 2;
+    }
+    
+    FILE* save_file = save_path ? fopen(save_path, "wb") : nullptr;
+    if (save_path && !save_file) {
+        fprintf(stderr, "cannot write %s\n", save_path);
+        return 2;
+    }
+    
+    GoldenHashes results;
+    int failures = 0;
+    
+    printf("%-10s %6s %10s  %s\n", "scenario", "frames", "us/frame", "result");
+    for (const Scenario& scenario : scenarios) {
+        if (only && strcmp(only, scenario.name) != 0) continue;
+    
+        // Hashes come from the first run; later runs only time the scenario,
+        // since state such as the dither error carries over
+        RunResult result = run_scenario(scenario);
+        double best_us = result.us_per_frame;
+        for (int r = 0; r < repeat; r++) {
+            best_us = std::min(best_us, run_scenario(scenario).us_per_frame);
+        }
+    
+        std::vector<uint64_t>& hashes = results[scenario.name];
+        for (const Frame& frame : result.frames) {
+            hashes.push_back(hash_frame(frame));
+        }
+    
+        std::string verdict = "ok";
+        if (!result.well_formed) {
+            verdict = "FAIL malformed DMA words";
+        } else if (frames_path) {
+            const auto found = reference.find(scenario.name);
+            if (found == reference.end() || found->second.size() != result.frames.size()) {
+                verdict = "FAIL no reference frames";
+            } else {
+                for (size_t f = 0; f < result.frames.size(); f++) {
+                    const int difference = max_channel_difference(result.frames[f], found->second[f]);
+                    if (difference > tolerance) {
+                        verdict = "FAIL frame " + std::to_string(f) + " differs by " + std::to_string(difference);
+                        break;
+                    }
+                }
+            }
+        } else if (!update) {
+            const auto found = golden.find(scenario.name);
+            if (found == golden.end() || found->second.size() != hashes.size()) {
+                verdict = "FAIL no golden hashes";
+            } else {
+                const auto mismatch = std::mismatch(hashes.begin(), hashes.end(), found->second.begin());
+                if (mismatch.first != hashes.end()) {
+                    verdict = "FAIL frame " + std::to_string(mismatch.first - hashes.begin());
+                }
+            }
+        }
+    
+        if (verdict != "ok") failures++;
+        printf("%-10s %6u %10.2f  %s\n", scenario.name, scenario.frames, best_us, verdict.c_str());
+    
+        if (save_file && !save_frames(save_file, scenario, result)) {
+            fprintf(stderr, "cannot write %s\n", save_path);
+            return 2;
+        }
+    }
+    
+    if (save_file) fclose(save_file);
+    
+    if (update) {
+        FILE* file = fopen(golden_path, "w");
+        if (!file) {
+            fprintf(stderr, "cannot write %s\n", golden_path);
+            return 2;
+        }
+        fprintf(file, "# scenario frame fnv1a64, written by golden_frames --update\n");
+        for (const Scenario& scenario : scenarios) {
+            const auto found = results.find(scenario.name);
+            if (found == results.end()) continue;
+            for (size_t f = 0; f < found->second.size(); f++) {
+                fprintf(file, "%s %zu %016llx\n", scenario.name, f, (unsigned long long)found->second[f]);
+            }
+        }
+        fclose(file);
+        printf("wrote %s\n", golden_path);
+    }
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+#include "host_fakes.h"
+
+#include <string.h>
+#include <array>
+#include <chrono>
+
+#include "hardware/dma.h"
+#include "pio_manager.h"
+
+static std::array<CapturedFrame, NUM_DMA_CHANNELS> captured{};
+
+// Wall clock, so the controller's own render timing still means something
+static uint64_t host_now_us() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+uint32_t time_us_32() { return (uint32_t)host_now_us(); }
+uint64_t time_us_64() { return host_now_us(); }
+absolute_time_t get_absolute_time() { return host_now_us(); }
+uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void* read_addr, uint32_t transfer_count) {
+    captured[channel] = CapturedFrame{(const uint32_t*)read_addr, transfer_count};
+}
+
+CapturedFrame host_strip_frame(uint strip) {
+    // Strip drivers claim their channel as "strip<n>"
+    char owner[] = "strip0";
+    owner[5] = '0' + strip;
+    
+    const PioManager& manager = PioManager::instance();
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        const char* channel_owner = manager.get_dma_owner(channel);
+        if (channel_owner && strcmp(channel_owner, owner) == 0) {
+            return captured[channel];
+        }
+    }
+    return CapturedFrame{nullptr, 0};
+}
+
+PioManager& PioManager::instance() {
+    static PioManager manager;
+    return manager;
+}
+
+PioAllocation PioManager::claim_sm([[maybe_unused]] const pio_program_t* program, [[maybe_unused]] const char* program_name,
+                                   [[maybe_unused]] const char* owner, [[maybe_unused]] float clock_hz,
+                                   [[maybe_unused]] bool required) {
+    static pio_hw_t pio{};
+    static uint next_sm = 0;
+    return PioAllocation{&pio, next_sm++ % NUM_PIO_STATE_MACHINES, 0, true};
+}
+
+void PioManager::release_sm([[maybe_unused]] PIO pio, [[maybe_unused]] uint sm) {}
+
+int PioManager::claim_dma(const char* owner, [[maybe_unused]] bool required) {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (!dma_owners[channel]) {
+            dma_owners[channel] = owner;
+            captured[channel] = CapturedFrame{nullptr, 0};
+            return channel;
+        }
+    }
+    return -1;
+}
+
+void PioManager::release_dma(uint channel) {
+    dma_owners[channel] = nullptr;
+}
@@ -0,0 +1,25 @@
+#ifndef HOST_FAKES_H
+#define HOST_FAKES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+// Host-side pieces shared by the host builds: the clock, PioManager and
+// the capture of each strip's DMA words. The other singletons the
+// firmware sources touch are faked per program (golden_fakes.cpp,
+// sim_fakes.cpp).
+
+// Golden harness only: sets the virtual clock and latches it as the
+// current frame time, as a scheduler tick would on the device
+void host_set_time_us(uint64_t time_us);
+
+// Words the strip's last transfer would have clocked out
+struct CapturedFrame {
+    const uint32_t* words;
+    uint32_t count;
+};
+CapturedFrame host_strip_frame(uint strip);
+
+#endif  // HOST_FAKES_H
@@ -0,0 +1,13 @@
+#ifndef HOST_APA102_PIO_H
+#define HOST_APA102_PIO_H
+
+// Timing constants of apa102.pio; the program itself never runs on the host
+#include "hardware/pio.h"
+
+#define apa102_CYCLES_PER_BIT 2
+
+static const pio_program_t apa102_program = {nullptr, 0, -1};
+
+inline void apa102_program_init(PIO, uint, uint, uint, uint, uint) {}
+
+#endif  // HOST_APA102_PIO_H
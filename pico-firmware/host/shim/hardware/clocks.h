@@ -0,0 +1,6 @@
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+#endif  // HOST_HARDWARE_CLOCKS_H
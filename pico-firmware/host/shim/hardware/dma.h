@@ -0,0 +1,26 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+inline dma_channel_config dma_channel_get_default_config(uint) { return {}; }
+inline void channel_config_set_transfer_data_size(dma_channel_config*, enum dma_channel_transfer_size) {}
+inline void channel_config_set_read_increment(dma_channel_config*, bool) {}
+inline void channel_config_set_write_increment(dma_channel_config*, bool) {}
+inline void channel_config_set_dreq(dma_channel_config*, uint) {}
+inline void channel_config_set_bswap(dma_channel_config*, bool) {}
+inline void dma_channel_configure(uint, const dma_channel_config*, volatile void*, const volatile void*, uint, bool) {}
+inline void dma_channel_wait_for_finish_blocking(uint) {}
+
+// Captured by the harness: the words a strip's frame would clock out
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void* read_addr, uint32_t transfer_count);
+
+#endif  // HOST_HARDWARE_DMA_H
@@ -0,0 +1,27 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+#define NUM_BANK0_GPIOS 30
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+inline void gpio_init(uint) {}
+inline void gpio_deinit(uint) {}
+inline void gpio_set_dir(uint, bool) {}
+inline void gpio_put(uint, bool) {}
+inline void gpio_pull_up(uint) {}
+inline void gpio_set_input_hysteresis_enabled(uint, bool) {}
+inline void gpio_set_irq_enabled(uint, uint32_t, bool) {}
+
+// Button inputs; the simulator drives them (sim_fakes.cpp)
+void gpio_set_irq_callback(gpio_irq_callback_t callback);
+uint32_t gpio_get_all();
+
+#endif  // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,10 @@
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define IO_IRQ_BANK0 13
+
+inline void irq_set_enabled(uint, bool) {}
+
+#endif  // HOST_HARDWARE_IRQ_H
@@ -0,0 +1,23 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+
+typedef struct {
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+typedef pio_hw_t* PIO;
+
+typedef struct pio_program {
+    const uint16_t* instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+inline uint pio_get_dreq(PIO, uint sm, bool is_tx) { return sm * 2 + (is_tx ? 0 : 1); }
+
+#endif  // HOST_HARDWARE_PIO_H
@@ -0,0 +1,13 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+// Simulated interrupts run on the main thread between loop passes, so
+// masking them is a no-op; __get_current_exception() is non-zero while one
+// is being delivered (see sim_fakes.cpp)
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t) {}
+uint __get_current_exception();
+
+#endif  // HOST_HARDWARE_SYNC_H
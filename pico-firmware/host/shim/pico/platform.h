@@ -0,0 +1,6 @@
+#ifndef HOST_PICO_PLATFORM_H
+#define HOST_PICO_PLATFORM_H
+
+#define __not_in_flash_func(func_name) func_name
+
+#endif  // HOST_PICO_PLATFORM_H
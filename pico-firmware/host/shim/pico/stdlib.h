@@ -0,0 +1,21 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Host stand-in for the pico-sdk surface the LED pipeline uses; see
+// host/host_fakes.cpp for the definitions.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+uint32_t time_us_32();
+uint64_t time_us_64();
+absolute_time_t get_absolute_time();
+uint32_t to_ms_since_boot(absolute_time_t t);
+
+inline void tight_loop_contents() {}
+
+#endif  // HOST_PICO_STDLIB_H
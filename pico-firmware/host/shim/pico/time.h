@@ -0,0 +1,12 @@
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include "pico/stdlib.h"
+
+typedef struct repeating_timer repeating_timer_t;
+struct repeating_timer {
+    int64_t delay_us;
+    void* user_data;
+};
+
+#endif  // HOST_PICO_TIME_H
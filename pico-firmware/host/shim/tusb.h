@@ -0,0 +1,22 @@
+#ifndef HOST_TUSB_H
+#define HOST_TUSB_H
+
+// Host stand-in for the TinyUSB device CDC calls the firmware makes;
+// sim_usb.cpp puts the console on a pseudo-terminal.
+
+#include "pico/stdlib.h"
+
+#define CFG_TUSB_MCU 0
+#include "tusb_config.h"
+
+bool tusb_init();
+void tud_task();
+
+bool tud_cdc_n_connected(uint8_t itf);
+uint32_t tud_cdc_n_available(uint8_t itf);
+uint32_t tud_cdc_n_read(uint8_t itf, void* buffer, uint32_t bufsize);
+uint32_t tud_cdc_n_write(uint8_t itf, const void* buffer, uint32_t bufsize);
+uint32_t tud_cdc_n_write_flush(uint8_t itf);
+uint32_t tud_cdc_n_write_available(uint8_t itf);
+
+#endif  // HOST_TUSB_H
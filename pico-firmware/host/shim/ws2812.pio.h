@@ -0,0 +1,15 @@
+#ifndef HOST_WS2812_PIO_H
+#define HOST_WS2812_PIO_H
+
+// Timing constants of ws2812.pio; the program itself never runs on the host
+#include "hardware/pio.h"
+
+#define ws2812_T1 2
+#define ws2812_T2 5
+#define ws2812_T3 3
+
+static const pio_program_t ws2812_program = {nullptr, 0, -1};
+
+inline void ws2812_program_init(PIO, uint, uint, uint, float, bool) {}
+
+#endif  // HOST_WS2812_PIO_H
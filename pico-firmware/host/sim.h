@@ -0,0 +1,25 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#include <string>
+
+// Controls sim_main.cpp has over the simulated hardware
+
+// Puts the console CDC interface on a new pseudo-terminal, symlinked at
+// link_path when given; returns the path a host opens, empty on failure
+std::string sim_console_open(const char* link_path);
+void sim_console_close();
+
+// Sleeps until the host sends something or timeout_us passes, as the
+// device sleeps in __wfe() until the USB interrupt
+void sim_console_wait(uint32_t timeout_us);
+
+// Pulls the buttons of the players in player_mask low together and
+// delivers their falling edges to the GPIO IRQ callback, as if in the
+// interrupt; they read low until sim_release_buttons()
+void sim_press_buttons(uint32_t player_mask);
+void sim_release_buttons();
+
+#endif  // SIM_H
@@ -0,0 +1,280 @@
+#include "sim.h"
+#include "host_fakes.h"
+
+#include <algorithm>
+
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "audio_output.h"
+#include "bench.h"
+#include "clock_governor.h"
+#include "config_store.h"
+#include "data_port.h"
+#include "feud.h"
+#include "frame_scheduler.h"
+#include "pio_manager.h"
+#include "player_lamps.h"
+#include "system_monitor.h"
+
+// Singletons for the simulator. Frames are paced by the host clock and the
+// buttons by sim_press_buttons(); hardware with no host counterpart (flash,
+// clocks, audio, lamps, the data port) accepts requests and does nothing.
+
+// Buttons are pulled up, so a released bank reads high
+static uint32_t bank_state = ~0u;
+static gpio_irq_callback_t irq_callback = nullptr;
+static bool in_irq = false;
+
+void gpio_set_irq_callback(gpio_irq_callback_t callback) {
+    irq_callback = callback;
+}
+
+uint32_t gpio_get_all() {
+    return bank_state;
+}
+
+uint __get_current_exception() {
+    // Exception numbers of external IRQs start at 16
+    return in_irq ? 16 + IO_IRQ_BANK0 : 0;
+}
+
+void sim_press_buttons(uint32_t player_mask) {
+    const Feud& feud = Feud::instance();
+    uint32_t pins = 0;
+    for (uint i = 0; i < feud.get_player_count(); i++) {
+        if (player_mask & (1u << i)) {
+            pins |= 1u << feud.get_player_config(i).button_pin;
+        }
+    }
+    
+    // Every button is low before the first edge's IRQ samples the bank
+    bank_state &= ~pins;
+    if (!irq_callback) return;
+    
+    in_irq = true;
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (pins & (1u << gpio)) {
+            irq_callback(gpio, GPIO_IRQ_EDGE_FALL);
+        }
+    }
+    in_irq = false;
+}
+
+void sim_release_buttons() {
+    bank_state = ~0u;
+}
+
+// Ticks fall due on the host clock; a loop that falls more than a period
+// behind catches up in one frame and counts the rest as missed
+FrameScheduler& FrameScheduler::instance() {
+    static FrameScheduler scheduler;
+    return scheduler;
+}
+
+bool FrameScheduler::consume_frame() {
+    const uint64_t now = time_us_64();
+    if (now - tick_time_us < period_us) return false;
+    
+    const uint32_t ticks = (now - tick_time_us) / period_us;
+    missed_frames = missed_frames + (ticks - 1);
+    tick_count = tick_count + ticks;
+    tick_time_us = tick_time_us + (uint64_t)ticks * period_us;
+    
+    frame_count = tick_count;
+    frame_time_us = tick_time_us;
+    
+    const uint32_t latency = now - tick_time_us;
+    latency_max_us = std::max(latency_max_us, latency);
+    latency_sum_us += latency;
+    rendered_frames++;
+    
+    return true;
+}
+
+void FrameScheduler::set_rate(uint32_t hz) {
+    rate_hz = std::clamp(hz, MIN_FRAME_RATE_HZ, MAX_FRAME_RATE_HZ);
+    period_us = 1000000 / rate_hz;
+    reset_stats();
+}
+
+FrameStats FrameScheduler::get_stats() const {
+    FrameStats stats;
+    stats.rate_hz = rate_hz;
+    stats.frames = rendered_frames;
+    stats.missed = missed_frames;
+    stats.tick_jitter_max_us = tick_jitter_max_us;
+    stats.latency_avg_us = rendered_frames ? (uint32_t)(latency_sum_us / rendered_frames) : 0;
+    stats.latency_max_us = latency_max_us;
+    return stats;
+}
+
+void FrameScheduler::reset_stats() {
+    missed_frames = 0;
+    tick_jitter_max_us = 0;
+    rendered_frames = 0;
+    latency_max_us = 0;
+    latency_sum_us = 0;
+}
+
+// The host clock can't be changed; the governor stays at its reset level
+ClockGovernor& ClockGovernor::instance() {
+    static ClockGovernor governor;
+    return governor;
+}
+
+void ClockGovernor::report_render([[maybe_unused]] uint32_t render_us, [[maybe_unused]] uint32_t period_us) {}
+
+bool ClockGovernor::set_level([[maybe_unused]] ClockLevel new_level) {
+    return false;
+}
+
+uint32_t ClockGovernor::get_sys_hz() const {
+    return 125000000;
+}
+
+uint32_t ClockGovernor::get_level_time_ms(ClockLevel l) const {
+    return (l == level) ? to_ms_since_boot(get_absolute_time()) : 0;
+}
+
+const char* ClockGovernor::level_name(ClockLevel l) {
+    switch (l) {
+        case ClockLevel::IDLE: return "idle";
+        case ClockLevel::NORMAL: return "normal";
+        case ClockLevel::BOOST: return "boost";
+        default: return "?";
+    }
+}
+
+// No flash: settings last as long as the process
+ConfigStore& ConfigStore::instance() {
+    static ConfigStore store;
+    return store;
+}
+
+void ConfigStore::request_save() {}
+
+bool ConfigStore::clear() {
+    return true;
+}
+
+uint ConfigStore::get_slot_count() const {
+    return 0;
+}
+
+SystemMonitor& SystemMonitor::instance() {
+    static SystemMonitor monitor;
+    return monitor;
+}
+
+const char* SystemMonitor::phase_name(LoopPhase phase) {
+    switch (phase) {
+        case LoopPhase::GAME:
+            return "game";
+        case LoopPhase::LEDS:
+            return "leds";
+        case LoopPhase::CONFIG:
+            return "config";
+        case LoopPhase::USB:
+            return "usb";
+        default:
+            return "unknown";
+    }
+}
+
+const char* SystemMonitor::reset_reason_name(ResetReason reason) {
+    switch (reason) {
+        case ResetReason::POWER_ON:
+            return "power_on";
+        case ResetReason::RUN_PIN:
+            return "run_pin";
+        case ResetReason::DEBUGGER:
+            return "debugger";
+        case ResetReason::WATCHDOG:
+            return "watchdog";
+        case ResetReason::SOFTWARE:
+            return "software";
+        default:
+            return "unknown";
+    }
+}
+
+// The on-target measurements mean nothing here; a run reports no samples
+Benchmark& Benchmark::instance() {
+    static Benchmark benchmark;
+    return benchmark;
+}
+
+BenchResult Benchmark::run([[maybe_unused]] uint samples) {
+    return BenchResult{};
+}
+
+const char* Benchmark::profile_name() {
+    return "host";
+}
+
+AudioOutput& AudioOutput::instance() {
+    static AudioOutput audio;
+    return audio;
+}
+
+void AudioOutput::play([[maybe_unused]] Sound sound) {
+    if (!enabled) return;
+    plays++;
+}
+
+void AudioOutput::set_enabled(bool on) {
+    enabled = on;
+}
+
+void AudioOutput::set_volume(uint8_t level) {
+    volume = level;
+}
+
+const char* AudioOutput::sound_name(Sound sound) {
+    switch (sound) {
+        case Sound::BUZZER: return "buzzer";
+        case Sound::TIMER_EXPIRED: return "expired";
+        default: return "?";
+    }
+}
+
+PlayerLamps& PlayerLamps::instance() {
+    static PlayerLamps lamps;
+    return lamps;
+}
+
+bool PlayerLamps::can_drive([[maybe_unused]] const uint* lamp_pins, [[maybe_unused]] uint count) const {
+    return true;
+}
+
+bool PlayerLamps::configure([[maybe_unused]] const uint* lamp_pins, [[maybe_unused]] uint count) {
+    return true;
+}
+
+void PlayerLamps::release() {}
+
+void PlayerLamps::show([[maybe_unused]] LampPattern pattern, [[maybe_unused]] uint32_t period_ms,
+                       [[maybe_unused]] uint32_t lamp_mask) {}
+
+// The data interface is never opened; see sim_usb.cpp
+DataPort& DataPort::instance() {
+    static DataPort port;
+    return port;
+}
+
+bool DataPort::is_connected() const {
+    return false;
+}
+
+uint PioManager::get_dma_channels_used() const {
+    uint used = 0;
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (dma_owners[channel]) used++;
+    }
+    return used;
+}
+
+uint PioBlockInfo::sms_used() const {
+    return 0;
+}
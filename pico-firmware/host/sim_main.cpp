@@ -0,0 +1,463 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "sim.h"
+#include "host_fakes.h"
+#include "command_handler.h"
+#include "feud.h"
+#include "usb_serial.h"
+#include "ws2812_controller.h"
+
+// The game firmware on the host: the real Feud, CommandHandler, USBSerial
+// and WS2812Controller, with the console on a pseudo-terminal that the app
+// or any terminal program opens like the device's serial port.
+//
+//   feud_sim [--link PATH] [--script FILE]
+//       Serves the console at PATH (default /tmp/feud-sim) until Ctrl-C.
+//       Start the app with FEUD_SIM_PORT=PATH to list it. On exit, prints
+//       firmware-side latency percentiles.
+//
+//   feud_sim --bench [--count N] [--presses N] [--commands "status;players"]
+//       Drives the console from a built-in client instead and also prints
+//       round-trip percentiles per command and press-to-status latency.
+//
+// A script injects button presses and console lines, one step per line,
+// at milliseconds since the script (re)started:
+//
+//   500 press A          player A's button; "AB" presses A and B together
+//   2000 console start_timer 30
+//   10000 repeat         runs the script again from the top
+
+static constexpr const char* DEFAULT_LINK = "/tmp/feud-sim";
+static constexpr uint32_t LOOP_WAIT_US = 1000;
+static constexpr uint32_t PRESS_HOLD_MS = 50;
+static constexpr uint32_t REPLY_TIMEOUT_MS = 2000;
+
+// Sent after each bench command: lines are handled in order, so its reply
+// marks the end of the command's output
+static constexpr std::string_view SYNC_COMMAND = "hello sync\n";
+static constexpr std::string_view SYNC_REPLY = "Hello, sync!";
+
+// Latency samples in microseconds by name, reported as nearest-rank percentiles
+using SampleSet = std::map<std::string, std::vector<uint32_t>>;
+
+struct Options {
+    const char* link = DEFAULT_LINK;
+    const char* script = nullptr;
+    bool bench = false;
+    uint32_t count = 200;
+    uint32_t presses = 100;
+    std::string commands = "status;players;frame_stats;usbstats;led_all 255 0 0";
+};
+
+struct ScriptStep {
+    enum class Action { PRESS, CONSOLE, REPEAT };
+    
+    uint32_t at_ms;
+    Action action;
+    uint32_t players = 0;
+    std::string line;
+};
+
+struct BenchSamples {
+    SampleSet reply_first;  // Command sent to first reply line read
+    SampleSet reply_done;   // Command sent to last reply line read
+    SampleSet press;        // Button edge to status line read
+};
+
+static volatile sig_atomic_t stop_requested = 0;
+
+// Firmware side, owned by the loop
+static SampleSet command_us;  // Newline read to command handled
+static SampleSet press_us;    // Button edge to status line queued
+static uint64_t release_at_us = 0;
+static uint64_t unannounced_edge_us = 0;  // A press the loop hasn't reported yet
+
+// Bench client requests and the loop delivers, as an IRQ would arrive
+static std::atomic<uint32_t> press_request{0};
+static std::atomic<uint64_t> press_edge_us{0};
+
+static void on_signal(int) {
+    stop_requested = 1;
+}
+
+static std::string_view command_name(std::string_view line) {
+    const size_t start = line.find_first_not_of(" \t");
+    if (start == std::string_view::npos) return {};
+    line.remove_prefix(start);
+    return line.substr(0, line.find_first_of(" \t"));
+}
+
+static void on_line_received(std::string_view line) {
+    const uint64_t rx_us = USBSerial::instance().get_line_rx_us();
+    CommandHandler::instance().handle_line(line);
+    
+    const std::string_view name = command_name(line);
+    if (!name.empty()) {
+        command_us[std::string(name)].push_back(time_us_64() - rx_us);
+    }
+}
+
+static void press_buttons(uint32_t player_mask) {
+    const uint64_t edge_us = time_us_64();
+    press_edge_us = edge_us;
+    sim_press_buttons(player_mask);
+    unannounced_edge_us = edge_us;
+    release_at_us = edge_us + PRESS_HOLD_MS * 1000;
+}
+
+static void print_samples(const char* title, SampleSet& samples) {
+    if (samples.empty()) return;
+    
+    printf("\n%s\n%-24s %6s %8s %8s %8s %8s\n", title, "", "n", "p50", "p90", "p99", "max");
+    for (auto& [name, values] : samples) {
+        std::sort(values.begin(), values.end());
+        const auto percentile = [&values](uint32_t p) {
+            const size_t rank = (values.size() * p + 99) / 100;
+            return values[std::max<size_t>(rank, 1) - 1];
+        };
+        printf("%-24s %6zu %8u %8u %8u %8u\n", name.c_str(), values.size(), percentile(50), percentile(90),
+               percentile(99), values.back());
+    }
+}
+
+static bool parse_players(std::string_view letters, uint32_t& mask) {
+    mask = 0;
+    for (char c : letters) {
+        const int player = (c >= 'a') ? c - 'a' : c - 'A';
+        if (player < 0 || player >= (int)MAX_PLAYERS) return false;
+        mask |= 1u << player;
+    }
+    return mask != 0;
+}
+
+static bool load_script(const char* path, std::vector<ScriptStep>& steps) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "feud_sim: can't open script %s\n", path);
+        return false;
+    }
+    
+    std::string text;
+    for (uint line_number = 1; std::getline(file, text); line_number++) {
+        std::string_view line = text;
+        const size_t end = line.find_last_not_of(" \t\r");
+        line = line.substr(0, end == std::string_view::npos ? 0 : end + 1);
+        if (command_name(line).empty() || command_name(line)[0] == '#') continue;
+    
+        ScriptStep step{};
+        char action[16] = {};
+        int consumed = 0;
+        const std::string copy(line);
+        const bool parsed = sscanf(copy.c_str(), " %u %15s %n", &step.at_ms, action, &consumed) == 2;
+        const std::string_view rest = line.substr(consumed);
+    
+        bool valid = parsed && (steps.empty() || step.at_ms >= steps.back().at_ms);
+        if (valid && strcmp(action, "press") == 0) {
+            step.action = ScriptStep::Action::PRESS;
+            valid = parse_players(rest, step.players);
+        } else if (valid && strcmp(action, "console") == 0) {
+            step.action = ScriptStep::Action::CONSOLE;
+            step.line = rest;
+            valid = !rest.empty();
+        } else if (valid && strcmp(action, "repeat") == 0) {
+            // A repeat at 0 would never let the loop run
+            step.action = ScriptStep::Action::REPEAT;
+            valid = step.at_ms > 0;
+        } else {
+            valid = false;
+        }
+    
+        if (!valid) {
+            fprintf(stderr, "feud_sim: %s:%u: bad step '%s'\n", path, line_number, text.c_str());
+            return false;
+        }
+        steps.push_back(std::move(step));
+    }
+    return true;
+}
+
+// Host end of the terminal for the bench, reading whole lines
+class BenchClient {
+ private:
+    int fd = -1;
+    std::string buffer;
+    uint64_t buffer_time_us = 0;  // When the newest bytes in the buffer were read
+
+ public:
+    ~BenchClient() {
+        if (fd >= 0) close(fd);
+    }
+    
+    bool open_port(const std::string& path) {
+        fd = open(path.c_str(), O_RDWR | O_NOCTTY);
+        if (fd < 0) return false;
+    
+        termios settings;
+        tcgetattr(fd, &settings);
+        cfmakeraw(&settings);
+        tcsetattr(fd, TCSANOW, &settings);
+        return true;
+    }
+    
+    bool send(std::string_view text) {
+        return write(fd, text.data(), text.size()) == (ssize_t)text.size();
+    }
+    
+    // Next line without its terminator, and when it was read
+    bool read_line(std::string& line, uint64_t& read_us) {
+        const uint64_t deadline_us = time_us_64() + REPLY_TIMEOUT_MS * 1000ull;
+        size_t newline;
+        while ((newline = buffer.find('\n')) == std::string::npos) {
+            const uint64_t now = time_us_64();
+            if (stop_requested || now >= deadline_us) return false;
+    
+            pollfd pfd{fd, POLLIN, 0};
+            if (poll(&pfd, 1, (deadline_us - now + 999) / 1000) <= 0) continue;
+    
+            char chunk[256];
+            const ssize_t count = read(fd, chunk, sizeof(chunk));
+            if (count <= 0) return false;
+            buffer.append(chunk, count);
+            buffer_time_us = time_us_64();
+        }
+    
+        line.assign(buffer, 0, newline);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        buffer.erase(0, newline + 1);
+        read_us = buffer_time_us;
+        return true;
+    }
+    
+    // Sends the sync command and reads up to its reply; the unsolicited
+    // status lines a running round prints are not part of any reply
+    bool exchange(std::string_view text, uint64_t* first_us, uint64_t* done_us) {
+        std::string request(text);
+        request += SYNC_COMMAND;
+        if (!send(request)) return false;
+    
+        std::string line;
+        uint64_t read_us = 0;
+        bool first = true;
+        while (read_line(line, read_us)) {
+            if (line.starts_with("status:")) continue;
+            if (line == SYNC_REPLY) {
+                if (done_us) *done_us = read_us;
+                return true;
+            }
+            if (first && first_us) *first_us = read_us;
+            first = false;
+            if (done_us) *done_us = read_us;
+        }
+        return false;
+    }
+};
+
+static bool run_bench(const std::string& port, const Options& options, BenchSamples& samples) {
+    BenchClient client;
+    if (!client.open_port(port)) {
+        fprintf(stderr, "feud_sim: can't open %s\n", port.c_str());
+        return false;
+    }
+    
+    // The greeting is held until a host connects; skip past it
+    if (!client.exchange("", nullptr, nullptr)) {
+        fprintf(stderr, "feud_sim: no reply from the console\n");
+        return false;
+    }
+    
+    std::string_view commands = options.commands;
+    while (!commands.empty()) {
+        const size_t end = commands.find(';');
+        const std::string command(commands.substr(0, end));
+        commands.remove_prefix(end == std::string_view::npos ? commands.size() : end + 1);
+        if (command_name(command).empty()) continue;
+    
+        for (uint32_t i = 0; i < options.count; i++) {
+            const uint64_t sent_us = time_us_64();
+            uint64_t first_us = 0;
+            uint64_t done_us = 0;
+            if (!client.exchange(command + "\n", &first_us, &done_us)) {
+                fprintf(stderr, "feud_sim: no reply to '%s'\n", command.c_str());
+                return false;
+            }
+            // A command with no output replies with the sync line alone
+            samples.reply_first[command].push_back((first_us ? first_us : done_us) - sent_us);
+            samples.reply_done[command].push_back(done_us - sent_us);
+        }
+    }
+    
+    // Alternate single presses, with a tie every fifth round
+    for (uint32_t i = 0; i < options.presses; i++) {
+        // Past the previous press's hold and every player's debounce
+        std::this_thread::sleep_for(std::chrono::milliseconds(PRESS_HOLD_MS + 10));
+        if (!client.exchange("reset_game\nstart_timer 300\n", nullptr, nullptr)) {
+            fprintf(stderr, "feud_sim: couldn't start a round\n");
+            return false;
+        }
+    
+        const uint32_t players = (i % 5 == 4) ? 0x3 : 1u << (i % 2);
+        press_edge_us = 0;
+        press_request = players;
+    
+        std::string line;
+        uint64_t read_us = 0;
+        bool seen = false;
+        const uint64_t deadline_us = time_us_64() + REPLY_TIMEOUT_MS * 1000ull;
+        while (!seen && time_us_64() < deadline_us && client.read_line(line, read_us)) {
+            seen = line.starts_with("status:") && line.find(" active=N") == std::string::npos;
+        }
+        if (!seen) {
+            fprintf(stderr, "feud_sim: no status line for press %u\n", i);
+            return false;
+        }
+        samples.press[(players == 0x3) ? "tie" : "single"].push_back(read_us - press_edge_us);
+    }
+    
+    return client.exchange("reset_game\n", nullptr, nullptr);
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: feud_sim [--link PATH] [--script FILE]\n"
+            "       feud_sim --bench [--link PATH] [--count N] [--presses N] [--commands \"cmd;cmd args\"]\n");
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--bench") {
+            options.bench = true;
+        } else if (arg == "--link" && has_value) {
+            options.link = argv[++i];
+        } else if (arg == "--script" && has_value) {
+            options.script = argv[++i];
+        } else if (arg == "--count" && has_value) {
+            options.count = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--presses" && has_value) {
+            options.presses = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--commands" && has_value) {
+            options.commands = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    
+    std::vector<ScriptStep> script;
+    if (options.script && !load_script(options.script, script)) {
+        return 1;
+    }
+    
+    // The console has to exist before USBSerial starts the stack
+    const std::string port = sim_console_open(options.link);
+    if (port.empty()) {
+        fprintf(stderr, "feud_sim: can't create the console terminal at %s: %s\n", options.link, strerror(errno));
+        return 1;
+    }
+    printf("console on %s\n", port.c_str());
+    fflush(stdout);
+    
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    
+    // Same bring-up as main.cpp, less the hardware the host doesn't have
+    Feud& feud = Feud::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    ws2812.set_animation(AnimationMode::RAINBOW, 50);
+    ws2812.update(true);
+    
+    USBSerial& usb_serial = USBSerial::instance();
+    usb_serial.set_line_callback(on_line_received);
+    usb_serial.queue_line("chantskis feud usb serial interface");
+    usb_serial.queue_line("type 'help' for available commands");
+    
+    BenchSamples bench;
+    bool bench_ok = true;
+    std::atomic<bool> bench_done{false};
+    std::thread client;
+    if (options.bench) {
+        client = std::thread([&] {
+            bench_ok = run_bench(port, options, bench);
+            bench_done = true;
+        });
+    }
+    
+    uint64_t script_start_us = time_us_64();
+    size_t next_step = 0;
+    while (!stop_requested && !bench_done) {
+        const uint64_t now = time_us_64();
+        if (release_at_us && now >= release_at_us) {
+            sim_release_buttons();
+            release_at_us = 0;
+        }
+        if (const uint32_t players = press_request.exchange(0)) {
+            press_buttons(players);
+        }
+    
+        while (next_step < script.size() && now - script_start_us >= script[next_step].at_ms * 1000ull) {
+            const ScriptStep& step = script[next_step++];
+            switch (step.action) {
+                case ScriptStep::Action::PRESS:
+                    press_buttons(step.players);
+                    break;
+                case ScriptStep::Action::CONSOLE:
+                    CommandHandler::instance().handle_line(step.line);
+                    break;
+                case ScriptStep::Action::REPEAT:
+                    script_start_us = now;
+                    next_step = 0;
+                    break;
+            }
+        }
+    
+        // The IRQ only latches the press; the status line goes out here
+        feud.update();
+        if (unannounced_edge_us) {
+            press_us["press"].push_back(time_us_64() - unannounced_edge_us);
+            unannounced_edge_us = 0;
+        }
+        ws2812.update();
+        usb_serial.update();
+    
+        sim_console_wait(LOOP_WAIT_US);
+    }
+    
+    if (client.joinable()) {
+        client.join();
+    }
+    
+    print_samples("firmware: newline read to command handled (us)", command_us);
+    print_samples("firmware: button edge to status line queued (us)", press_us);
+    print_samples("host: command sent to first reply line (us)", bench.reply_first);
+    print_samples("host: command sent to last reply line (us)", bench.reply_done);
+    print_samples("host: button edge to status line read (us)", bench.press);
+    
+    sim_console_close();
+    return bench_ok ? 0 : 1;
+}
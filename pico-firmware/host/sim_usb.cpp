@@ -0,0 +1,146 @@
+#include "sim.h"
+#include "tusb.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "usb_descriptors.h"
+
+// TinyUSB's CDC FIFOs in front of a pseudo-terminal master. The firmware
+// sees the same write_available() back-pressure as on the device, and a
+// host that stops reading fills the terminal and then the FIFO, as a
+// stalled USB host does. Only the console interface is served.
+
+static int master_fd = -1;
+static std::string link_name;
+static std::string rx_fifo;
+static std::string tx_fifo;
+
+// The master reports a hangup while no host has the terminal open, which
+// stands in for DTR
+static bool host_attached() {
+    if (master_fd < 0) return false;
+    
+    pollfd pfd{master_fd, POLLIN, 0};
+    poll(&pfd, 1, 0);
+    return !(pfd.revents & POLLHUP);
+}
+
+static void drain_tx() {
+    while (!tx_fifo.empty()) {
+        const ssize_t written = write(master_fd, tx_fifo.data(), tx_fifo.size());
+        if (written <= 0) break;
+        tx_fifo.erase(0, written);
+    }
+}
+
+std::string sim_console_open(const char* link_path) {
+    master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+        sim_console_close();
+        return {};
+    }
+    
+    // Raw bytes both ways, whatever the host's serial library leaves set
+    termios settings;
+    tcgetattr(master_fd, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(master_fd, TCSANOW, &settings);
+    fcntl(master_fd, F_SETFL, fcntl(master_fd, F_GETFL) | O_NONBLOCK);
+    
+    const std::string slave = ptsname(master_fd);
+    if (!link_path) return slave;
+    
+    unlink(link_path);
+    if (symlink(slave.c_str(), link_path) != 0) {
+        sim_console_close();
+        return {};
+    }
+    link_name = link_path;
+    return link_name;
+}
+
+void sim_console_close() {
+    if (master_fd >= 0) {
+        close(master_fd);
+        master_fd = -1;
+    }
+    if (!link_name.empty()) {
+        unlink(link_name.c_str());
+        link_name.clear();
+    }
+}
+
+void sim_console_wait(uint32_t timeout_us) {
+    const timespec timeout{(time_t)(timeout_us / 1000000), (long)(timeout_us % 1000000) * 1000};
+    if (!host_attached()) {
+        nanosleep(&timeout, nullptr);
+        return;
+    }
+    
+    pollfd pfd{master_fd, POLLIN, 0};
+    ppoll(&pfd, 1, &timeout, nullptr);
+}
+
+bool tusb_init() {
+    return master_fd >= 0;
+}
+
+void tud_task() {
+    if (!host_attached()) return;
+    
+    // Host to device, as far as the FIFO has room
+    uint8_t chunk[CFG_TUD_CDC_EP_BUFSIZE];
+    while (rx_fifo.size() < CFG_TUD_CDC_RX_BUFSIZE) {
+        const size_t room = std::min(sizeof(chunk), CFG_TUD_CDC_RX_BUFSIZE - rx_fifo.size());
+        const ssize_t count = read(master_fd, chunk, room);
+        if (count <= 0) break;
+        rx_fifo.append((const char*)chunk, count);
+    }
+    
+    drain_tx();
+}
+
+bool tud_cdc_n_connected(uint8_t itf) {
+    return itf == USB_CDC_CONSOLE && host_attached();
+}
+
+uint32_t tud_cdc_n_available(uint8_t itf) {
+    return (itf == USB_CDC_CONSOLE) ? rx_fifo.size() : 0;
+}
+
+uint32_t tud_cdc_n_read(uint8_t itf, void* buffer, uint32_t bufsize) {
+    if (itf != USB_CDC_CONSOLE) return 0;
+    
+    const uint32_t count = std::min<size_t>(bufsize, rx_fifo.size());
+    rx_fifo.copy((char*)buffer, count);
+    rx_fifo.erase(0, count);
+    return count;
+}
+
+uint32_t tud_cdc_n_write(uint8_t itf, const void* buffer, uint32_t bufsize) {
+    if (itf != USB_CDC_CONSOLE) return 0;
+    
+    const uint32_t count = std::min<size_t>(bufsize, CFG_TUD_CDC_TX_BUFSIZE - tx_fifo.size());
+    tx_fifo.append((const char*)buffer, count);
+    return count;
+}
+
+uint32_t tud_cdc_n_write_flush(uint8_t itf) {
+    if (itf != USB_CDC_CONSOLE || !host_attached()) return 0;
+    
+    const size_t queued = tx_fifo.size();
+    drain_tx();
+    return queued - tx_fifo.size();
+}
+
+uint32_t tud_cdc_n_write_available(uint8_t itf) {
+    return (itf == USB_CDC_CONSOLE) ? CFG_TUD_CDC_TX_BUFSIZE - tx_fifo.size() : 0;
+}
@@ -0,0 +1,16 @@
+#ifndef HOT_PATH_H
+#define HOT_PATH_H
+
+#include "pico/platform.h"
+
+// Marks interrupt handlers and per-frame kernels. In the performance build
+// (FEUD_PERF_BUILD) they are copied to RAM so their timing no longer depends
+// on the XIP cache, which USB traffic and flash writes evict. The default
+// size build leaves them in flash.
+#if FEUD_PERF_BUILD
+#define HOT_PATH_FUNC(func_name) __not_in_flash_func(func_name)
+#else
+#define HOT_PATH_FUNC(func_name) func_name
+#endif
+
+#endif  // HOT_PATH_H
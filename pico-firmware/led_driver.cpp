@@ -0,0 +1,189 @@
+#include "led_driver.h"
+
+#include <algorithm>
+
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "ws2812_controller.h"
+#include "pio_manager.h"
+#include "ws2812.pio.h"
+#include "apa102.pio.h"
+#include "hot_path.h"
+
+static constexpr float WS2812_BIT_RATE = 800000;
+static constexpr uint WS2812_CYCLES_PER_BIT = ws2812_T1 + ws2812_T2 + ws2812_T3;
+
+// APA102 global brightness field; brightness is applied to the 8-bit channels
+static constexpr uint32_t APA102_LED_FRAME = (0xE0u | 31) << 24;
+
+const char* LedDriver::chip_name(LedChip chip) {
+    switch (chip) {
+        case LedChip::WS2812: return "ws2812";
+        case LedChip::SK6812_RGBW: return "sk6812";
+        case LedChip::APA102: return "apa102";
+        default: return "?";
+    }
+}
+
+void LedDriver::init_dma(const char* owner, bool byte_stream) {
+    dma_channel = PioManager::instance().claim_dma(owner, true);
+    
+    dma_channel_config dma_config = dma_channel_get_default_config(dma_channel);
+    
+    // 32-bit words from the buffer into the fixed PIO TX FIFO
+    channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_config, true);
+    channel_config_set_write_increment(&dma_config, false);
+    
+    // Little-endian words read back to front; swapped, the first byte in
+    // memory is the first out of the MSB-first shift register
+    channel_config_set_bswap(&dma_config, byte_stream);
+    
+    // Pace transfers based on PIO TX FIFO availability
+    channel_config_set_dreq(&dma_config, pio_get_dreq(pio, sm, true));
+    
+    dma_channel_configure(dma_channel, &dma_config, &pio->txf[sm], words, 0, false);
+}
+
+void LedDriver::release() {
+    if (dma_channel < 0) return;
+    
+    wait_idle();
+    PioManager::instance().release_dma(dma_channel);
+    PioManager::instance().release_sm(pio, sm);
+    dma_channel = -1;
+}
+
+void HOT_PATH_FUNC(LedDriver::transfer)() {
+    if (dma_channel < 0 || word_count == 0) return;
+    
+    // Wait for any previous transfer to complete
+    dma_channel_wait_for_finish_blocking(dma_channel);
+    dma_channel_transfer_from_buffer_now(dma_channel, words, word_count);
+}
+
+void LedDriver::wait_idle() const {
+    if (dma_channel >= 0) {
+        dma_channel_wait_for_finish_blocking(dma_channel);
+    }
+}
+
+// Returns a pin to a driven-low SIO output once its state machine is gone
+static void park_pin(uint pin) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+    gpio_put(pin, 0);
+}
+
+void WS2812Driver::init_program(uint pin, const char* owner) {
+    PioAllocation allocation = PioManager::instance().claim_sm(&ws2812_program, "ws2812", owner,
+                                                               WS2812_BIT_RATE * WS2812_CYCLES_PER_BIT, true);
+    pio = allocation.pio;
+    sm = allocation.sm;
+    data_pin = pin;
+    
+    park_pin(pin);
+    // Autopull at 32 bits: a packed GRB stream for WS2812, one GRBW word per SK6812 pixel
+    ws2812_program_init(pio, sm, allocation.offset, pin, WS2812_BIT_RATE, true);
+    init_dma(owner, true);
+}
+
+void WS2812Driver::init(uint pin, [[maybe_unused]] uint clock_pin, uint32_t* buffer, const char* owner) {
+    words = buffer;
+    word_count = 0;
+    init_program(pin, owner);
+}
+
+void WS2812Driver::release() {
+    LedDriver::release();
+    park_pin(data_pin);
+}
+
+void HOT_PATH_FUNC(WS2812Driver::encode)(const RGB* pixels, uint count) {
+    // Same size in and out, so in place only needs each pixel read whole
+    uint8_t* grb = grb_frame();
+    for (uint i = 0; i < count; i++, grb += 3) {
+        const RGB p = pixels[i];
+        grb[0] = p.g;
+        grb[1] = p.r;
+        grb[2] = p.b;
+    }
+    end_grb_frame(count);
+}
+
+void WS2812Driver::end_grb_frame(uint count) {
+    // Whole words only; the padding bits clock out past the last LED, which ignores them
+    const uint bytes = count * 3;
+    word_count = (bytes + 3) / 4;
+    std::fill(grb_frame() + bytes, grb_frame() + word_count * 4, 0);
+}
+
+uint32_t WS2812Driver::frame_time_us(uint count) const {
+    return (count * 24 * 1000000ull) / (uint32_t)WS2812_BIT_RATE + WS2812_RESET_NS / 1000;
+}
+
+void SK6812Driver::init(uint pin, [[maybe_unused]] uint clock_pin, uint32_t* buffer, const char* owner) {
+    words = buffer;
+    word_count = 0;
+    init_program(pin, owner);
+}
+
+void HOT_PATH_FUNC(SK6812Driver::encode)(const RGB* pixels, uint count) {
+    // Same byte stream as WS2812, four bytes per pixel: G, R, B, W
+    uint8_t* grbw = reinterpret_cast<uint8_t*>(words);
+    for (uint i = count; i-- > 0;) {
+        const RGB p = pixels[i];
+        const uint8_t w = std::min({p.r, p.g, p.b});
+        grbw[i * 4 + 0] = p.g - w;
+        grbw[i * 4 + 1] = p.r - w;
+        grbw[i * 4 + 2] = p.b - w;
+        grbw[i * 4 + 3] = w;
+    }
+    word_count = count;
+}
+
+uint32_t SK6812Driver::frame_time_us(uint count) const {
+    return (count * 32 * 1000000ull) / (uint32_t)WS2812_BIT_RATE + WS2812_RESET_NS / 1000;
+}
+
+void APA102Driver::init(uint pin, uint clk_pin, uint32_t* buffer, const char* owner) {
+    words = buffer;
+    word_count = 0;
+    data_pin = pin;
+    clock_pin = clk_pin;
+    
+    PioAllocation allocation = PioManager::instance().claim_sm(&apa102_program, "apa102", owner,
+                                                               (float)BAUD * apa102_CYCLES_PER_BIT, true);
+    pio = allocation.pio;
+    sm = allocation.sm;
+    
+    apa102_program_init(pio, sm, allocation.offset, BAUD, clock_pin, data_pin);
+    init_dma(owner);
+}
+
+void APA102Driver::release() {
+    LedDriver::release();
+    park_pin(data_pin);
+    park_pin(clock_pin);
+}
+
+void HOT_PATH_FUNC(APA102Driver::encode)(const RGB* pixels, uint count) {
+    // End frame: data is delayed half a clock per LED, so clock out count/2 more edges
+    const uint end_words = (count + 63) / 64;
+    for (uint i = 0; i < end_words; i++) {
+        words[1 + count + i] = 0xFFFFFFFF;
+    }
+    
+    for (uint i = count; i-- > 0;) {
+        const RGB p = pixels[i];
+        words[1 + i] = APA102_LED_FRAME | ((uint32_t)p.b << 16) | ((uint32_t)p.g << 8) | p.r;
+    }
+    
+    // Start frame, last as it overlays the first staged pixels
+    words[0] = 0;
+    word_count = 1 + count + end_words;
+}
+
+uint32_t APA102Driver::frame_time_us(uint count) const {
+    return ((uint64_t)led_driver_max_words(count) * 32 * 1000000) / BAUD;
+}
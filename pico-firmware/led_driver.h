@@ -0,0 +1,132 @@
+#ifndef LED_DRIVER_H
+#define LED_DRIVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+
+struct RGB;
+
+// LED chip families with an output driver
+enum class LedChip : uint8_t {
+    WS2812,         // 24-bit GRB, single wire, 800kHz
+    SK6812_RGBW,    // 32-bit GRBW, single wire, 800kHz
+    APA102,         // Clocked: start frame, 32-bit BGR + 5-bit brightness, end frame
+    COUNT
+};
+
+// Output words needed for a strip of led_count pixels with any driver
+// (APA102 adds a start frame and one end-frame word per 64 pixels)
+constexpr uint led_driver_max_words(uint led_count) {
+    return 1 + led_count + (led_count + 63) / 64;
+}
+
+// Output words for a packed GRB frame, 3 bytes per pixel
+constexpr uint led_driver_grb_words(uint led_count) {
+    return (led_count * 3 + 3) / 4;
+}
+
+// Output words a chip needs; only WS2812 fits the packed GRB size
+constexpr uint led_driver_words(LedChip chip, uint led_count) {
+    return (chip == LedChip::WS2812) ? led_driver_grb_words(led_count) : led_driver_max_words(led_count);
+}
+
+// One strip's output path. A driver owns the encode kernel that turns the
+// final 8-bit pixels into its wire format, and the state machine and DMA
+// channel that clock them out. The compositor and brightness/dither stage
+// never see the wire format.
+class LedDriver {
+ protected:
+    PIO pio = nullptr;
+    uint sm = 0;
+    int dma_channel = -1;
+    uint32_t* words = nullptr;  // Output buffer, led_driver_words() long for the chip
+    uint word_count = 0;        // Words in the current frame
+    
+    // Claims a DMA channel that feeds the state machine's TX FIFO;
+    // byte_stream swaps each word so buffer bytes go out in memory order
+    void init_dma(const char* owner, bool byte_stream = false);
+
+ public:
+    virtual ~LedDriver() = default;
+    
+    // Claims PIO and DMA resources; clock_pin is ignored by single-wire chips
+    virtual void init(uint data_pin, uint clock_pin, uint32_t* buffer, const char* owner) = 0;
+    
+    // Waits for the last frame, then returns all resources and pins
+    virtual void release();
+    
+    // Encode kernel: final pixels to wire words. pixels may be staged at
+    // the start of the driver's own buffer; every format is at least as
+    // wide as RGB, so the kernels expand back to front.
+    virtual void encode(const RGB* pixels, uint count) = 0;
+    
+    // Drivers whose wire format is packed GRB bytes let the brightness
+    // stage write straight into the output buffer instead of calling
+    // encode(): fill count * 3 bytes from grb_frame(), then end_grb_frame().
+    // nullptr if the chip needs encode().
+    virtual uint8_t* grb_frame() { return nullptr; }
+    virtual void end_grb_frame([[maybe_unused]] uint count) {}
+    
+    // Time on the wire for a frame of count pixels, including any latch gap
+    virtual uint32_t frame_time_us(uint count) const = 0;
+    
+    virtual LedChip chip() const = 0;
+    
+    // Starts clocking out the encoded frame once the previous one is done
+    void transfer();
+    void wait_idle() const;
+    bool is_active() const { return dma_channel >= 0; }
+    
+    static const char* chip_name(LedChip chip);
+};
+
+// WS2812B and compatibles on the shared ws2812 program. The buffer holds
+// the frame as packed GRB bytes, 3 per LED, which DMA byte-swaps into the
+// state machine a word at a time; pixel boundaries need not align with
+// words because the program only ever shifts single bits.
+class WS2812Driver : public LedDriver {
+ protected:
+    uint data_pin = 0;
+    
+    void init_program(uint pin, const char* owner);
+
+ public:
+    void init(uint data_pin, uint clock_pin, uint32_t* buffer, const char* owner) override;
+    void release() override;
+    void encode(const RGB* pixels, uint count) override;
+    uint8_t* grb_frame() override { return reinterpret_cast<uint8_t*>(words); }
+    void end_grb_frame(uint count) override;
+    uint32_t frame_time_us(uint count) const override;
+    LedChip chip() const override { return LedChip::WS2812; }
+};
+
+// SK6812 RGBW: the common white level is moved into the W channel
+class SK6812Driver : public WS2812Driver {
+ public:
+    void init(uint data_pin, uint clock_pin, uint32_t* buffer, const char* owner) override;
+    void encode(const RGB* pixels, uint count) override;
+    uint8_t* grb_frame() override { return nullptr; }
+    uint32_t frame_time_us(uint count) const override;
+    LedChip chip() const override { return LedChip::SK6812_RGBW; }
+};
+
+// APA102 / SK9822 on a TX-only SPI program; clocked, so no latch gap
+class APA102Driver : public LedDriver {
+ private:
+    uint data_pin = 0;
+    uint clock_pin = 0;
+
+ public:
+    static constexpr uint32_t BAUD = 4000000;
+    
+    void init(uint data_pin, uint clock_pin, uint32_t* buffer, const char* owner) override;
+    void release() override;
+    void encode(const RGB* pixels, uint count) override;
+    uint32_t frame_time_us(uint count) const override;
+    LedChip chip() const override { return LedChip::APA102; }
+};
+
+#endif  // LED_DRIVER_H
@@ -1,15 +1,18 @@
 #include <stdio.h>
 
 #include "hardware/clocks.h"
-#include "hardware/pll.h"
 #include "hardware/sync.h"
-#include "hardware/xosc.h"
 #include "pico/stdlib.h"
 #include "feud.h"
 #include "usb_serial.h"
 #include "command_handler.h"
 #include "ws2812_controller.h"
 #include "ws2812_led.h"
+#include "config_store.h"
+#include "system_monitor.h"
+#include "clock_governor.h"
+#include "audio_output.h"
+#include "data_port.h"
 
 // Callback function for when a line is received
 static void on_line_received(std::string_view line) {
@@ -19,35 +22,56 @@ static void on_line_received(std::string_view line) {
 int main() {
     WS2812Led::instance().set_blue();
 
-    // Initialize stdio (required for USB)
-    stdio_init_all();
+    // Level shifter enable for the LED strips
+    gpio_init(LEVEL_SHIFTER_ENABLE_PIN);
+    gpio_set_dir(LEVEL_SHIFTER_ENABLE_PIN, GPIO_OUT);
+    gpio_put(LEVEL_SHIFTER_ENABLE_PIN, 1);
 
-    gpio_init(8);
-    gpio_set_dir(8, GPIO_OUT);
-    gpio_put(8, 1);
+    // Game hardware first: buttons/IRQ, timer, strips and sound are live before USB
+    AudioOutput& audio = AudioOutput::instance();
+    Feud& feud = Feud::instance();
+    WS2812Controller& ws2812 = WS2812Controller::instance();
+    
+    // Restore saved settings, or start with the default rainbow animation
+    ConfigStore& config_store = ConfigStore::instance();
+    if (!config_store.restore()) {
+        ws2812.set_animation(AnimationMode::RAINBOW, 50);
+    }
+    ws2812.update(true);
+
+    // After a watchdog reset, come back into the interrupted round
+    SystemMonitor& monitor = SystemMonitor::instance();
+    monitor.restore_game_state();
 
+    // USB enumerates in the background; the greeting is held until a host connects
     USBSerial& usb_serial = USBSerial::instance();
     usb_serial.set_line_callback(on_line_received);
-    
-    sleep_ms(1000);
+    usb_serial.queue_line("chantskis feud usb serial interface");
+    usb_serial.queue_line("type 'help' for available commands");
+    DataPort& data_port = DataPort::instance();
 
-    WS2812Led::instance().set_green();
+    ClockGovernor& clock_governor = ClockGovernor::instance();
     
-    usb_serial.send_line("chantskis feud usb serial interface");
-    usb_serial.send_line("type 'help' for available commands");
-
-    Feud& feud = Feud::instance();
-    WS2812Controller& ws2812 = WS2812Controller::instance();
-    
-    // Set default rainbow animation on startup
-    ws2812.set_animation(AnimationMode::RAINBOW, 50);
-
+    monitor.mark_ready();
+    monitor.start_watchdog();
     WS2812Led::instance().set_red();
     
     while (1) {
+        monitor.begin_iteration();
         feud.update();
+        audio.update();
+        monitor.end_phase(LoopPhase::GAME);
         ws2812.update();
+        monitor.end_phase(LoopPhase::LEDS);
+        config_store.update();
+        clock_governor.update(feud.get_state() != GameState::IDLE);
+        monitor.end_phase(LoopPhase::CONFIG);
         usb_serial.update();
-        sleep_ms(10);  // Small delay instead of WFI to ensure regular updates
+        data_port.update();
+        monitor.end_phase(LoopPhase::USB);
+        monitor.end_iteration();
+        
+        // Sleep until the next frame tick or any other interrupt
+        __wfe();
     }
 }
@@ -0,0 +1,137 @@
+#include "pio_manager.h"
+
+#include "hardware/clocks.h"
+#include "pico/stdlib.h"
+#include "clock_governor.h"
+
+PioManager& PioManager::instance() {
+    static PioManager manager;
+    if (!manager.initialized) {
+        manager.initialized = true;
+        manager.init();
+    }
+    return manager;
+}
+
+void PioManager::init() {
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        blocks[i].pio = pio_get_instance(i);
+    }
+    ClockGovernor::instance().add_listener(on_clock_change);
+}
+
+const PioProgramInfo* PioManager::find_program(const PioBlockInfo& block, const pio_program_t* program) const {
+    for (size_t i = 0; i < block.program_count; i++) {
+        if (block.programs[i].program == program) {
+            return &block.programs[i];
+        }
+    }
+    return nullptr;
+}
+
+bool PioManager::load_program(PioBlockInfo& block, const pio_program_t* program, const char* name) {
+    if (block.program_count >= PIO_MAX_PROGRAMS || !pio_can_add_program(block.pio, program)) {
+        return false;
+    }
+    
+    PioProgramInfo& loaded = block.programs[block.program_count++];
+    loaded.program = program;
+    loaded.name = name;
+    loaded.offset = pio_add_program(block.pio, program);
+    block.instructions_used += program->length;
+    return true;
+}
+
+PioAllocation PioManager::claim_sm(const pio_program_t* program, const char* program_name,
+                                   const char* owner, float clock_hz, bool required) {
+    PioAllocation allocation{};
+    
+    // Prefer a block that already holds the program, then any block it fits in
+    for (int pass = 0; pass < 2 && !allocation.valid; pass++) {
+        for (auto& block : blocks) {
+            const PioProgramInfo* loaded = find_program(block, program);
+            if (pass == 0 && !loaded) continue;
+    
+            int sm = pio_claim_unused_sm(block.pio, false);
+            if (sm < 0) continue;
+    
+            if (!loaded) {
+                if (!load_program(block, program, program_name)) {
+                    pio_sm_unclaim(block.pio, sm);
+                    continue;
+                }
+                loaded = &block.programs[block.program_count - 1];
+            }
+    
+            block.sms[sm].owner = owner;
+            block.sms[sm].clock_hz = clock_hz;
+            allocation = {block.pio, (uint)sm, loaded->offset, true};
+            break;
+        }
+    }
+    
+    if (!allocation.valid && required) {
+        panic("No PIO state machine for %s", owner);
+    }
+    return allocation;
+}
+
+void PioManager::release_sm(PIO pio, uint sm) {
+    PioBlockInfo& block = blocks[pio_get_index(pio)];
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_unclaim(pio, sm);
+    block.sms[sm] = PioSmInfo{};
+}
+
+float PioManager::clkdiv(uint32_t sys_hz, float clock_hz) {
+    return sys_hz / clock_hz;
+}
+
+float PioManager::get_clkdiv(float clock_hz) {
+    return clkdiv(clock_get_hz(clk_sys), clock_hz);
+}
+
+void PioManager::on_clock_change(uint32_t sys_hz) {
+    PioManager& manager = PioManager::instance();
+    for (auto& block : manager.blocks) {
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            if (block.sms[sm].owner && block.sms[sm].clock_hz > 0) {
+                pio_sm_set_clkdiv(block.pio, sm, clkdiv(sys_hz, block.sms[sm].clock_hz));
+                pio_sm_clkdiv_restart(block.pio, sm);
+            }
+        }
+    }
+}
+
+int PioManager::claim_dma(const char* owner, bool required) {
+    int channel = dma_claim_unused_channel(false);
+    if (channel < 0) {
+        if (required) {
+            panic("No DMA channel for %s", owner);
+        }
+        return -1;
+    }
+    dma_owners[channel] = owner;
+    return channel;
+}
+
+void PioManager::release_dma(uint channel) {
+    dma_channel_unclaim(channel);
+    dma_owners[channel] = nullptr;
+}
+
+uint PioManager::get_dma_channels_used() const {
+    uint used = 0;
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (dma_channel_is_claimed(channel)) used++;
+    }
+    return used;
+}
+
+uint PioBlockInfo::sms_used() const {
+    uint used = 0;
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (pio_sm_is_claimed(pio, sm)) used++;
+    }
+    return used;
+}
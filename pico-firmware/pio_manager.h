@@ -0,0 +1,85 @@
+#ifndef PIO_MANAGER_H
+#define PIO_MANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+
+// A state machine handed out by the manager, running a shared program copy
+struct PioAllocation {
+    PIO pio;
+    uint sm;
+    uint offset;    // Where the program is loaded in this PIO block
+    bool valid;
+};
+
+constexpr size_t PIO_MAX_PROGRAMS = 4;
+
+struct PioProgramInfo {
+    const pio_program_t* program = nullptr;
+    const char* name = nullptr;
+    uint offset = 0;
+};
+
+struct PioSmInfo {
+    const char* owner = nullptr;
+    float clock_hz = 0;   // State machine clock; 0 leaves the divider alone
+};
+
+// Bookkeeping for one PIO block
+struct PioBlockInfo {
+    PIO pio;
+    std::array<PioProgramInfo, PIO_MAX_PROGRAMS> programs{};
+    size_t program_count = 0;
+    uint instructions_used = 0;
+    std::array<PioSmInfo, NUM_PIO_STATE_MACHINES> sms{};
+    
+    uint sms_used() const;
+};
+
+// Central owner of PIO instruction memory, state machines and DMA
+// channels. Each program is loaded at most once per PIO block and shared
+// by every state machine that runs it; state machines are packed into the
+// block that already holds their program. Every claimed state machine
+// records the clock it needs, so all PIO dividers are re-derived in one
+// place when clk_sys changes.
+class PioManager {
+ private:
+    bool initialized = false;
+    
+    std::array<PioBlockInfo, NUM_PIOS> blocks{};
+    std::array<const char*, NUM_DMA_CHANNELS> dma_owners{};
+    
+    void init();
+    const PioProgramInfo* find_program(const PioBlockInfo& block, const pio_program_t* program) const;
+    bool load_program(PioBlockInfo& block, const pio_program_t* program, const char* name);
+    static float clkdiv(uint32_t sys_hz, float clock_hz);
+    static void on_clock_change(uint32_t sys_hz);
+
+ public:
+    static PioManager& instance();
+    
+    // Claims a state machine for program, loading the program if no block
+    // has a copy yet. clock_hz is the state machine clock the program's
+    // timing assumes (bit rate times cycles per bit). Like the SDK claim
+    // functions, required panics instead of returning an invalid claim.
+    PioAllocation claim_sm(const pio_program_t* program, const char* program_name,
+                           const char* owner, float clock_hz, bool required);
+    void release_sm(PIO pio, uint sm);
+    
+    // Divider for clock_hz at the current clk_sys
+    static float get_clkdiv(float clock_hz);
+    
+    int claim_dma(const char* owner, bool required);
+    void release_dma(uint channel);
+    
+    // Utilization
+    const PioBlockInfo& get_block(uint index) const { return blocks[index]; }
+    const char* get_dma_owner(uint channel) const { return dma_owners[channel]; }
+    uint get_dma_channels_used() const;
+};
+
+#endif  // PIO_MANAGER_H
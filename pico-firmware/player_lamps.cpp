@@ -0,0 +1,225 @@
+#include "player_lamps.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "clock_governor.h"
+#include "pio_manager.h"
+
+PlayerLamps& PlayerLamps::instance() {
+    static PlayerLamps lamps;
+    if (!lamps.initialized) {
+        lamps.initialized = true;
+        lamps.init();
+    }
+    return lamps;
+}
+
+void PlayerLamps::init() {
+    ClockGovernor::instance().add_listener(on_clock_change);
+}
+
+bool PlayerLamps::is_lamp_pin(uint gpio) const {
+    for (uint i = 0; i < pin_count; i++) {
+        if (pins[i] == gpio) return true;
+    }
+    return false;
+}
+
+int PlayerLamps::find_tick_slice(const uint* lamp_pins, uint count) const {
+    uint32_t busy = 0;
+    for (uint i = 0; i < count; i++) {
+        busy |= 1u << pwm_gpio_to_slice_num(lamp_pins[i]);
+    }
+    
+    // A slice without PWM outputs is a bare timer; the current lamps are about to be released
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (gpio_get_function(gpio) == GPIO_FUNC_PWM && !is_lamp_pin(gpio)) {
+            busy |= 1u << pwm_gpio_to_slice_num(gpio);
+        }
+    }
+    
+    for (uint slice = 0; slice < NUM_PWM_SLICES; slice++) {
+        if (!(busy & (1u << slice))) return slice;
+    }
+    return -1;
+}
+
+bool PlayerLamps::can_drive(const uint* lamp_pins, uint count) const {
+    if (count > MAX_LAMPS) return false;
+    
+    uint32_t lamp_slices = 0;
+    for (uint i = 0; i < count; i++) {
+        lamp_slices |= 1u << pwm_gpio_to_slice_num(lamp_pins[i]);
+    }
+    if ((uint)std::popcount(lamp_slices) > MAX_LAMP_SLICES) return false;
+    
+    // Patterns rewrite the whole compare register, so a lamp cannot share
+    // its slice with another PWM output such as the audio pin
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if ((lamp_slices & (1u << pwm_gpio_to_slice_num(gpio))) &&
+            gpio_get_function(gpio) == GPIO_FUNC_PWM && !is_lamp_pin(gpio) &&
+            std::find(lamp_pins, lamp_pins + count, gpio) == lamp_pins + count) {
+            return false;
+        }
+    }
+    
+    return find_tick_slice(lamp_pins, count) >= 0;
+}
+
+bool PlayerLamps::configure(const uint* lamp_pins, uint count) {
+    if (!can_drive(lamp_pins, count)) return false;
+    
+    const int tick = find_tick_slice(lamp_pins, count);
+    release();
+    tick_slice = tick;
+    
+    ClockGovernor& governor = ClockGovernor::instance();
+    for (uint i = 0; i < count; i++) {
+        pins[i] = lamp_pins[i];
+        
+        const uint slice = pwm_gpio_to_slice_num(pins[i]);
+        uint s = 0;
+        while (s < slice_count && slices[s].slice != slice) s++;
+        if (s == slice_count) {
+            // Pattern channels run for as long as the pattern and follow the tick slice across clock switches
+            slices[s] = LampSlice{slice, PioManager::instance().claim_dma("lamps", true)};
+            governor.exempt_from_drain(slices[s].dma_channel);
+            slice_count++;
+        }
+    }
+    pin_count = count;
+    
+    // Full clk_sys, 16-bit: a ~2kHz carrier, with levels fine enough for smooth fades
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_wrap(&config, LAMP_WRAP);
+    for (uint s = 0; s < slice_count; s++) {
+        pwm_init(slices[s].slice, &config, true);
+    }
+    for (uint i = 0; i < pin_count; i++) {
+        gpio_set_function(pins[i], GPIO_FUNC_PWM);
+    }
+    
+    pwm_config tick_config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&tick_config, TICK_CLKDIV);
+    pwm_init(tick_slice, &tick_config, false);
+    return true;
+}
+
+void PlayerLamps::release() {
+    stop_patterns();
+    
+    for (uint s = 0; s < slice_count; s++) {
+        pwm_set_enabled(slices[s].slice, false);
+        ClockGovernor::instance().exempt_from_drain(slices[s].dma_channel, false);
+        PioManager::instance().release_dma(slices[s].dma_channel);
+    }
+    for (uint i = 0; i < pin_count; i++) {
+        gpio_deinit(pins[i]);
+    }
+    
+    slice_count = 0;
+    pin_count = 0;
+    tick_slice = -1;
+}
+
+void PlayerLamps::stop_patterns() {
+    for (uint s = 0; s < slice_count; s++) {
+        dma_channel_abort(slices[s].dma_channel);
+    }
+    if (tick_slice >= 0) {
+        pwm_set_enabled(tick_slice, false);
+    }
+    period_ms = 0;
+}
+
+void PlayerLamps::show(LampPattern pattern, uint32_t pattern_ms, uint32_t lamp_mask) {
+    stop_patterns();
+    pattern_changes++;
+    
+    const bool animated = (pattern == LampPattern::BLINK || pattern == LampPattern::BREATHE);
+    uint32_t start_mask = 0;
+    
+    for (uint s = 0; s < slice_count; s++) {
+        const LampSlice& lamp_slice = slices[s];
+    
+        uint32_t channels = 0;
+        for (uint i = 0; i < pin_count; i++) {
+            if (pwm_gpio_to_slice_num(pins[i]) == lamp_slice.slice && (lamp_mask & (1u << i))) {
+                channels |= 1u << pwm_gpio_to_channel(pins[i]);
+            }
+        }
+    
+        auto& table = tables[s];
+        for (uint step = 0; step < PATTERN_STEPS; step++) {
+            const uint32_t level = pattern_level(pattern, step);
+            table[step] = ((channels & (1u << PWM_CHAN_B)) ? level << 16 : 0) |
+                          ((channels & (1u << PWM_CHAN_A)) ? level : 0);
+        }
+        pwm_hw->slice[lamp_slice.slice].cc = table[0];
+    
+        if (!animated) continue;
+    
+        // Step 0 is already showing; the ring wraps back to it after the last step.
+        // RP2040 DMA has no endless mode, so the pattern freezes once the
+        // maximum count is spent: after 2^32 / (PATTERN_STEPS * 1000 / period)
+        // transfers, about 77 days at MIN_PERIOD_MS. Feud's 500ms blink lasts
+        // over a year and its 2s breathe over four, and every state change
+        // calls show() again, which starts a fresh count.
+        dma_channel_config config = dma_channel_get_default_config(lamp_slice.dma_channel);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+        channel_config_set_read_increment(&config, true);
+        channel_config_set_write_increment(&config, false);
+        channel_config_set_ring(&config, false, PATTERN_RING_BITS);
+        channel_config_set_dreq(&config, pwm_get_dreq(tick_slice));
+        dma_channel_configure(lamp_slice.dma_channel, &config, &pwm_hw->slice[lamp_slice.slice].cc,
+                              &table[1], 0xFFFFFFFF, false);
+        start_mask |= 1u << lamp_slice.dma_channel;
+    }
+    
+    if (!animated || tick_slice < 0) return;
+    
+    period_ms = std::clamp(pattern_ms, MIN_PERIOD_MS, MAX_PERIOD_MS);
+    set_tick_rate(clock_get_hz(clk_sys));
+    pwm_set_counter(tick_slice, 0);
+    dma_start_channel_mask(start_mask);
+    pwm_set_enabled(tick_slice, true);
+}
+
+void PlayerLamps::set_tick_rate(uint32_t sys_hz) {
+    // PATTERN_STEPS wraps per pattern period
+    const uint64_t ticks = (uint64_t)(sys_hz / TICK_CLKDIV) * period_ms / (1000 * PATTERN_STEPS);
+    pwm_set_wrap(tick_slice, std::clamp<uint64_t>(ticks, 2, 0x10000) - 1);
+}
+
+void PlayerLamps::on_clock_change(uint32_t sys_hz) {
+    PlayerLamps& lamps = PlayerLamps::instance();
+    if (lamps.period_ms > 0) {
+        lamps.set_tick_rate(sys_hz);
+    }
+}
+
+uint16_t PlayerLamps::pattern_level(LampPattern pattern, uint step) {
+    switch (pattern) {
+        case LampPattern::ON:
+            return LAMP_FULL;
+    
+        case LampPattern::BLINK:
+            return (step < PATTERN_STEPS / 2) ? LAMP_FULL : 0;
+    
+        case LampPattern::BREATHE: {
+            // Raised cosine, squared so the lamp lingers near dark as the eye expects
+            const float wave = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * step / PATTERN_STEPS);
+            return (uint16_t)lrintf(LAMP_FULL * wave * wave);
+        }
+    
+        case LampPattern::OFF:
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef PLAYER_LAMPS_H
+#define PLAYER_LAMPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "pico/stdlib.h"
+
+constexpr uint MAX_LAMPS = 8;
+
+// Lamps on more slices than this are rejected; each needs a DMA channel
+constexpr uint MAX_LAMP_SLICES = 4;
+
+enum class LampPattern : uint8_t {
+    OFF,
+    ON,
+    BLINK,      // On for the first half of the period
+    BREATHE     // Smooth rise and fall over the period
+};
+
+// Player podium lamps on hardware PWM. Each slice carrying a lamp runs a
+// ~2kHz carrier; a DMA channel per slice copies compare values from a
+// 64-step pattern table into it, paced by the wrap DREQ of a spare slice
+// that serves as a timer. Patterns therefore play without any CPU work
+// and without loop jitter, and show() is only needed when they change.
+class PlayerLamps {
+ private:
+    bool initialized = false;
+    
+    static constexpr uint PATTERN_STEPS = 64;
+    static constexpr uint PATTERN_RING_BITS = 8;   // 64 32-bit CC values
+    static constexpr uint16_t LAMP_WRAP = 0xFFFE;  // A level of 0xFFFF is fully on
+    static constexpr uint16_t LAMP_FULL = 0xFFFF;
+    static constexpr uint TICK_CLKDIV = 250;
+    static constexpr uint32_t MIN_PERIOD_MS = 100;
+    static constexpr uint32_t MAX_PERIOD_MS = 4000;
+    
+    struct LampSlice {
+        uint slice;
+        int dma_channel;
+    };
+    
+    alignas(1u << PATTERN_RING_BITS) std::array<std::array<uint32_t, PATTERN_STEPS>, MAX_LAMP_SLICES> tables{};
+    std::array<LampSlice, MAX_LAMP_SLICES> slices{};
+    uint slice_count = 0;
+    
+    std::array<uint, MAX_LAMPS> pins{};
+    uint pin_count = 0;
+    
+    int tick_slice = -1;
+    uint32_t period_ms = 0;     // Current pattern period, 0 while static
+    
+    // Statistics
+    uint32_t pattern_changes = 0;
+    
+    void init();
+    bool is_lamp_pin(uint gpio) const;
+    void stop_patterns();
+    int find_tick_slice(const uint* lamp_pins, uint count) const;
+    void set_tick_rate(uint32_t sys_hz);
+    static uint16_t pattern_level(LampPattern pattern, uint step);
+    static void on_clock_change(uint32_t sys_hz);
+
+ public:
+    static PlayerLamps& instance();
+    
+    // Whether the lamp pins fit the slice and timer budget
+    bool can_drive(const uint* lamp_pins, uint count) const;
+    
+    // Takes over the lamp pins, all off; release() hands them back to SIO
+    bool configure(const uint* lamp_pins, uint count);
+    void release();
+    
+    // Lamps in lamp_mask (bit per configured pin) play pattern, others are off
+    void show(LampPattern pattern, uint32_t period_ms, uint32_t lamp_mask = ~0u);
+    
+    uint get_slice_count() const { return slice_count; }
+    int get_tick_slice() const { return tick_slice; }
+    uint32_t get_period_ms() const { return period_ms; }
+    uint32_t get_pattern_changes() const { return pattern_changes; }
+};
+
+#endif  // PLAYER_LAMPS_H
@@ -0,0 +1,130 @@
+#include "system_monitor.h"
+#include "feud.h"
+
+#include <algorithm>
+
+#include "hardware/structs/vreg_and_chip_reset.h"
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+
+SystemMonitor& SystemMonitor::instance() {
+    static SystemMonitor monitor;
+    if (!monitor.initialized) {
+        monitor.initialized = true;
+        monitor.init();
+    }
+    return monitor;
+}
+
+void SystemMonitor::init() {
+    if (watchdog_caused_reboot()) {
+        // watchdog_reboot() also goes through the watchdog
+        reset_reason = watchdog_enable_caused_reboot() ? ResetReason::WATCHDOG : ResetReason::SOFTWARE;
+    } else if (vreg_and_chip_reset_hw->chip_reset & VREG_AND_CHIP_RESET_CHIP_RESET_HAD_RUN_BITS) {
+        reset_reason = ResetReason::RUN_PIN;
+    } else if (vreg_and_chip_reset_hw->chip_reset & VREG_AND_CHIP_RESET_CHIP_RESET_HAD_PSM_RESTART_BITS) {
+        reset_reason = ResetReason::DEBUGGER;
+    } else {
+        reset_reason = ResetReason::POWER_ON;
+    }
+}
+
+void SystemMonitor::mark_ready() {
+    // The system timer starts counting at reset
+    boot_to_ready_us = time_us_32();
+}
+
+void SystemMonitor::start_watchdog() {
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    iteration_start = phase_start = time_us_32();
+}
+
+void SystemMonitor::save_game_state() {
+    const FeudSnapshot game = Feud::instance().snapshot();
+    
+    // Scratch 0-3 survive a watchdog reboot; 4-7 are used by the SDK
+    const uint32_t state = (uint32_t)game.state |
+                           (game.pressed_mask << 8) |
+                           (game.winner_mask << 16);
+    const uint32_t remaining = game.time_remaining;
+    
+    watchdog_hw->scratch[0] = GAME_STATE_MAGIC;
+    watchdog_hw->scratch[1] = state;
+    watchdog_hw->scratch[2] = remaining;
+    watchdog_hw->scratch[3] = GAME_STATE_MAGIC ^ state ^ remaining;
+}
+
+bool SystemMonitor::restore_game_state() {
+    if (reset_reason != ResetReason::WATCHDOG) return false;
+    
+    const uint32_t magic = watchdog_hw->scratch[0];
+    const uint32_t state = watchdog_hw->scratch[1];
+    const uint32_t remaining = watchdog_hw->scratch[2];
+    if (magic != GAME_STATE_MAGIC || watchdog_hw->scratch[3] != (magic ^ state ^ remaining)) {
+        return false;
+    }
+    
+    game_state_restored = Feud::instance().restore_state(
+        (GameState)(state & 0xFF), remaining, (state >> 8) & 0xFF, (state >> 16) & 0xFF);
+    return game_state_restored;
+}
+
+void SystemMonitor::begin_iteration() {
+    iteration_start = phase_start = time_us_32();
+}
+
+void SystemMonitor::end_phase(LoopPhase phase) {
+    const uint32_t now = time_us_32();
+    phase_us[(size_t)phase] = now - phase_start;
+    phase_start = now;
+}
+
+void SystemMonitor::end_iteration() {
+    const uint32_t elapsed = time_us_32() - iteration_start;
+    worst_iteration_us = std::max(worst_iteration_us, elapsed);
+    
+    if (elapsed > LOOP_BUDGET_US) {
+        // Blame the phase that took longest this iteration
+        const size_t worst = std::max_element(phase_us.begin(), phase_us.end()) - phase_us.begin();
+        overruns++;
+        phase_overruns[worst]++;
+        last_overrun_phase = (LoopPhase)worst;
+        last_overrun_us = elapsed;
+    }
+    phase_us.fill(0);
+    
+    save_game_state();
+    watchdog_update();
+}
+
+const char* SystemMonitor::phase_name(LoopPhase phase) {
+    switch (phase) {
+        case LoopPhase::GAME:
+            return "game";
+        case LoopPhase::LEDS:
+            return "leds";
+        case LoopPhase::CONFIG:
+            return "config";
+        case LoopPhase::USB:
+            return "usb";
+        default:
+            return "unknown";
+    }
+}
+
+const char* SystemMonitor::reset_reason_name(ResetReason reason) {
+    switch (reason) {
+        case ResetReason::POWER_ON:
+            return "power_on";
+        case ResetReason::RUN_PIN:
+            return "run_pin";
+        case ResetReason::DEBUGGER:
+            return "debugger";
+        case ResetReason::WATCHDOG:
+            return "watchdog";
+        case ResetReason::SOFTWARE:
+            return "software";
+        default:
+            return "unknown";
+    }
+}
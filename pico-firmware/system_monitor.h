@@ -0,0 +1,83 @@
+#ifndef SYSTEM_MONITOR_H
+#define SYSTEM_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+// Main loop phases, in execution order
+enum class LoopPhase {
+    GAME,
+    LEDS,
+    CONFIG,
+    USB,
+    COUNT
+};
+
+enum class ResetReason {
+    POWER_ON,
+    RUN_PIN,
+    DEBUGGER,
+    WATCHDOG,
+    SOFTWARE
+};
+
+// System-level health: boot timing, main loop budget and the hardware
+// watchdog. The loop is timed phase by phase; an iteration that exceeds
+// its budget is counted against the phase that took longest. Each
+// iteration feeds the watchdog and stores the game state in the watchdog
+// scratch registers, so a hang reboots into the last known game state.
+class SystemMonitor {
+ private:
+    bool initialized = false;
+    uint32_t boot_to_ready_us = 0;
+    ResetReason reset_reason = ResetReason::POWER_ON;
+    bool game_state_restored = false;
+    
+    static constexpr uint32_t LOOP_BUDGET_US = 5000;
+    static constexpr uint32_t WATCHDOG_TIMEOUT_MS = 1000;
+    static constexpr uint32_t GAME_STATE_MAGIC = 0xFE0D5AFE;
+    
+    // Loop timing
+    uint32_t iteration_start = 0;
+    uint32_t phase_start = 0;
+    std::array<uint32_t, (size_t)LoopPhase::COUNT> phase_us{};
+    
+    // Overrun statistics
+    uint32_t overruns = 0;
+    std::array<uint32_t, (size_t)LoopPhase::COUNT> phase_overruns{};
+    LoopPhase last_overrun_phase = LoopPhase::GAME;
+    uint32_t last_overrun_us = 0;
+    uint32_t worst_iteration_us = 0;
+    
+    void init();
+    void save_game_state();
+    
+ public:
+    static SystemMonitor& instance();
+    
+    // Records the time from reset until buttons, timer and strips are live
+    void mark_ready();
+    uint32_t get_boot_to_ready_us() const { return boot_to_ready_us; }
+    
+    // Watchdog; restores the game state saved before a watchdog reboot
+    void start_watchdog();
+    bool restore_game_state();
+    ResetReason get_reset_reason() const { return reset_reason; }
+    static const char* reset_reason_name(ResetReason reason);
+    
+    // Loop instrumentation
+    void begin_iteration();
+    void end_phase(LoopPhase phase);
+    void end_iteration();
+    
+    uint32_t get_overruns() const { return overruns; }
+    uint32_t get_phase_overruns(LoopPhase phase) const { return phase_overruns[(size_t)phase]; }
+    LoopPhase get_last_overrun_phase() const { return last_overrun_phase; }
+    uint32_t get_last_overrun_us() const { return last_overrun_us; }
+    uint32_t get_worst_iteration_us() const { return worst_iteration_us; }
+    uint32_t get_loop_budget_us() const { return LOOP_BUDGET_US; }
+    static const char* phase_name(LoopPhase phase);
+};
+
+#endif  // SYSTEM_MONITOR_H
@@ -0,0 +1,29 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// TinyUSB configuration for the composite device in usb_descriptors.cpp:
+// two CDC ports, the text console and the binary data port.
+
+#ifndef CFG_TUSB_MCU
+#error CFG_TUSB_MCU must be defined
+#endif
+
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+
+// The stack only runs from the main loop (USBSerial::update), so it needs no locking
+#define CFG_TUSB_OS OPT_OS_NONE
+
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC 2
+#define CFG_TUD_MSC 0
+#define CFG_TUD_HID 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+// Sized for the data port: a whole strip frame fits in the RX FIFO
+#define CFG_TUD_CDC_RX_BUFSIZE 1024
+#define CFG_TUD_CDC_TX_BUFSIZE 1024
+#define CFG_TUD_CDC_EP_BUFSIZE 64
+
+#endif  // TUSB_CONFIG_H
@@ -0,0 +1,124 @@
+#include "usb_descriptors.h"
+
+#include <string.h>
+#include <algorithm>
+#include <array>
+
+#include "tusb.h"
+#include "pico/bootrom.h"
+#include "pico/unique_id.h"
+
+// Raspberry Pi's VID and the SDK's CDC PID; the bumped bcdDevice makes
+// hosts re-read the descriptors of this two-port layout
+static constexpr uint16_t USB_VID = 0x2E8A;
+static constexpr uint16_t USB_PID = 0x000A;
+static constexpr uint16_t USB_BCD_DEVICE = 0x0200;
+
+enum {
+    ITF_NUM_CONSOLE = 0,
+    ITF_NUM_CONSOLE_DATA,
+    ITF_NUM_DATA_PORT,
+    ITF_NUM_DATA_PORT_DATA,
+    ITF_NUM_TOTAL
+};
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CONSOLE,
+    STRID_DATA_PORT,
+    STRID_COUNT
+};
+
+static constexpr uint8_t EP_CONSOLE_NOTIF = 0x81;
+static constexpr uint8_t EP_CONSOLE_OUT = 0x02;
+static constexpr uint8_t EP_CONSOLE_IN = 0x82;
+static constexpr uint8_t EP_DATA_NOTIF = 0x83;
+static constexpr uint8_t EP_DATA_OUT = 0x04;
+static constexpr uint8_t EP_DATA_IN = 0x84;
+
+static constexpr uint16_t CONFIG_TOTAL_LEN = TUD_CONFIG_DESC_LEN + 2 * TUD_CDC_DESC_LEN;
+
+static const tusb_desc_device_t device_descriptor = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    
+    // Interface association descriptors group each CDC's two interfaces
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = USB_BCD_DEVICE,
+    
+    .iManufacturer = STRID_MANUFACTURER,
+    .iProduct = STRID_PRODUCT,
+    .iSerialNumber = STRID_SERIAL,
+    .bNumConfigurations = 1
+};
+
+static const uint8_t configuration_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 250),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CONSOLE, STRID_CONSOLE, EP_CONSOLE_NOTIF, 8, EP_CONSOLE_OUT, EP_CONSOLE_IN, 64),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_DATA_PORT, STRID_DATA_PORT, EP_DATA_NOTIF, 8, EP_DATA_OUT, EP_DATA_IN, 64),
+};
+static_assert(sizeof(configuration_descriptor) == CONFIG_TOTAL_LEN);
+
+// Interface names let the host tell the two ports apart
+static constexpr std::array<const char*, STRID_COUNT> strings = {
+    nullptr,            // Language, sent as a code below
+    "chantskis",
+    "chantskis feud",
+    nullptr,            // Board unique ID
+    "feud console",
+    "feud data",
+};
+
+const uint8_t* tud_descriptor_device_cb() {
+    return reinterpret_cast<const uint8_t*>(&device_descriptor);
+}
+
+const uint8_t* tud_descriptor_configuration_cb([[maybe_unused]] uint8_t index) {
+    return configuration_descriptor;
+}
+
+const uint16_t* tud_descriptor_string_cb(uint8_t index, [[maybe_unused]] uint16_t langid) {
+    static constexpr size_t MAX_CHARS = 31;
+    static uint16_t descriptor[MAX_CHARS + 1];
+    
+    size_t length = 0;
+    if (index == STRID_LANGID) {
+        descriptor[1] = 0x0409;  // English (US)
+        length = 1;
+    } else if (index < STRID_COUNT) {
+        char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+        const char* text = strings[index];
+        if (index == STRID_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            text = serial;
+        }
+    
+        length = std::min(strlen(text), MAX_CHARS);
+        for (size_t i = 0; i < length; i++) {
+            descriptor[1 + i] = text[i];
+        }
+    } else {
+        return nullptr;
+    }
+    
+    descriptor[0] = (TUSB_DESC_STRING << 8) | (2 * length + 2);
+    return descriptor;
+}
+
+// A 1200 baud open of the console reboots into the USB bootloader, as
+// with the SDK's stdio_usb, so uploaders can still flash without BOOTSEL
+void tud_cdc_line_coding_cb(uint8_t itf, const cdc_line_coding_t* line_coding) {
+    if (itf == USB_CDC_CONSOLE && line_coding->bit_rate == 1200) {
+        reset_usb_boot(0, 0);
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef USB_DESCRIPTORS_H
+#define USB_DESCRIPTORS_H
+
+#include <stdint.h>
+
+// CDC instances of the composite device, for the tud_cdc_n_* calls.
+// The console carries text commands and game events; the data port
+// carries binary frames and telemetry (see data_port.h), so bulk traffic
+// never queues in front of a status line.
+constexpr uint8_t USB_CDC_CONSOLE = 0;
+constexpr uint8_t USB_CDC_DATA = 1;
+
+#endif  // USB_DESCRIPTORS_H
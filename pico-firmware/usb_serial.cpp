@@ -2,11 +2,12 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <bit>
 #include "pico/stdlib.h"
-#include "pico/stdio/driver.h"
-#include "pico/stdio_usb.h"
 #include "hardware/irq.h"
+#include "tusb.h"
+#include "usb_descriptors.h"
 
 USBSerial& USBSerial::instance() {
     static USBSerial usb_serial;
@@ -18,7 +19,8 @@ USBSerial& USBSerial::instance() {
 }
 
 void USBSerial::init() {
-    stdio_usb_init();
+    // The composite device of usb_descriptors.cpp; enumeration proceeds in update()
+    tusb_init();
     
     rx_buffer.fill(0);
     rx_buffer_pos = 0;
@@ -37,11 +39,165 @@ void USBSerial::send_line(std::string_view line) {
     }
 }
 
+void USBSerial::queue_line(std::string_view line) {
+    if (is_connected() && pending_length == 0) {
+        send_line(line);
+        return;
+    }
+    
+    // Drop lines that don't fit rather than block
+    hold(line.data(), line.size(), true);
+}
+
+void USBSerial::hold(const char* data, size_t length, bool newline) {
+    // All of it or nothing, so a dropped line never leaves a fragment
+    if (pending_length + length + newline <= PENDING_SIZE) {
+        memcpy(pending_buffer.data() + pending_length, data, length);
+        pending_length += length;
+        if (newline) {
+            pending_buffer[pending_length++] = '\n';
+        }
+        stats.held_max = std::max<uint32_t>(stats.held_max, pending_length);
+    } else {
+        stats.held_dropped++;
+    }
+}
+
+void USBSerial::send_pending() {
+    if (pending_length == 0 || !is_connected()) return;
+    
+    write_console(pending_buffer.data(), pending_length);
+    pending_length = 0;
+}
+
+bool USBSerial::is_connected() const {
+    // True once enumerated and the host has asserted DTR
+    return tud_cdc_n_connected(USB_CDC_CONSOLE);
+}
+
 void USBSerial::send_data(const uint8_t* data, size_t length) {
-    for (size_t i = 0; i < length; i++) {
-        putchar(data[i]);
+    put_text(std::string_view{reinterpret_cast<const char*>(data), length});
+    flush();
+}
+
+void USBSerial::flush() {
+    if (tx_length == 0) return;
+    
+    send_pending();
+    write_console(tx_buffer.data(), tx_length);
+    tx_length = 0;
+}
+
+void USBSerial::write_console(const char* data, size_t length) {
+    // Like stdio_usb: output is dropped while no host has the port open,
+    // and a host that stops reading gets a bounded wait
+    if (!is_connected()) {
+        stats.tx_dropped += length;
+        return;
+    }
+    
+    // After a timeout, nothing is written until the host has read what is queued
+    if (tx_stalled) {
+        if (tud_cdc_n_write_available(USB_CDC_CONSOLE) < CFG_TUD_CDC_TX_BUFSIZE) {
+            stats.tx_dropped += length;
+            return;
+        }
+        tx_stalled = false;
+    }
+    
+    stats.tx_lines += std::count(data, data + length, '\n');
+    
+    const uint64_t start = time_us_64();
+    const uint64_t deadline = start + TX_TIMEOUT_US;
+    bool stalled = false;
+    while (length > 0) {
+        const uint32_t written = tud_cdc_n_write(USB_CDC_CONSOLE, data, length);
+        stats.tx_bytes += written;
+        data += written;
+        length -= written;
+        if (length == 0) break;
+        
+        // The FIFO is full: the host is not keeping up
+        stalled = true;
+        tud_cdc_n_write_flush(USB_CDC_CONSOLE);
+        tud_task();
+        if (!is_connected() || time_us_64() > deadline) {
+            stats.tx_timeouts++;
+            stats.tx_dropped += length;
+            tx_stalled = true;
+            break;
+        }
+    }
+    
+    const uint32_t queued = CFG_TUD_CDC_TX_BUFSIZE - tud_cdc_n_write_available(USB_CDC_CONSOLE);
+    stats.tx_queue_max = std::max(stats.tx_queue_max, queued);
+    tud_cdc_n_write_flush(USB_CDC_CONSOLE);
+    
+    if (stalled) {
+        const uint32_t waited = time_us_64() - start;
+        stats.tx_stalls++;
+        stats.tx_stall_us += waited;
+        stats.tx_stall_max_us = std::max(stats.tx_stall_max_us, waited);
+    }
+}
+
+void USBSerial::reset_stats() {
+    stats = UsbStats{};
+}
+
+void USBSerial::put_text(std::string_view text) {
+    while (!text.empty()) {
+        if (tx_length == TX_BUFFER_SIZE) flush();
+        
+        const size_t chunk = std::min(text.size(), TX_BUFFER_SIZE - tx_length);
+        memcpy(tx_buffer.data() + tx_length, text.data(), chunk);
+        tx_length += chunk;
+        text.remove_prefix(chunk);
+    }
+}
+
+void USBSerial::put_unsigned(uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+    
+    // Stay in 32-bit arithmetic where possible; 64-bit division is a library call on the M0+
+    if (value <= UINT32_MAX) {
+        uint32_t v = (uint32_t)value;
+        do {
+            digits[count++] = '0' + v % 10;
+            v /= 10;
+        } while (v);
+    } else {
+        do {
+            digits[count++] = '0' + value % 10;
+            value /= 10;
+        } while (value);
+    }
+    
+    while (count > 0) {
+        put_char(digits[--count]);
+    }
+}
+
+void USBSerial::put_signed(int64_t value) {
+    if (value < 0) {
+        put_char('-');
+        put_unsigned(-(uint64_t)value);
+    } else {
+        put_unsigned(value);
+    }
+}
+
+void USBSerial::put_hex(Hex hex) {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+    
+    int digits = 8;
+    while (digits > 1 && digits > hex.width && !(hex.value >> ((digits - 1) * 4))) {
+        digits--;
+    }
+    for (int i = digits - 1; i >= 0; i--) {
+        put_char(hex_digits[(hex.value >> (i * 4)) & 0xF]);
     }
-    fflush(stdout);
 }
 
 void USBSerial::process_rx_buffer() {
@@ -55,6 +211,7 @@ void USBSerial::process_rx_buffer() {
             rx_buffer[line_length - 1] = '\0';
         }
         
+        stats.rx_lines++;
         if (line_callback) {
             line_callback(std::string_view{rx_buffer.data()});
         }
@@ -71,23 +228,49 @@ void USBSerial::process_rx_buffer() {
     }
 }
 
-void USBSerial::update() {
-    int c;
-    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
-        if (rx_buffer_pos < BUFFER_SIZE - 1) {
-            rx_buffer[rx_buffer_pos++] = (char)c;
-            rx_buffer[rx_buffer_pos] = '\0';
-            
-            if (c == '\n') {
-                process_rx_buffer();
-            }
-        } else {
+void USBSerial::receive_char(char c) {
+    if (rx_discarding) {
+        rx_discarding = (c != '\n');
+        return;
+    }
+    
+    if (rx_buffer_pos < BUFFER_SIZE - 1) {
+        rx_buffer[rx_buffer_pos++] = c;
+        rx_buffer[rx_buffer_pos] = '\0';
+        
+        if (c == '\n') {
+            previous_line_rx_us = line_rx_us;
+            line_rx_us = time_us_64();
             process_rx_buffer();
-            
-            if (rx_buffer_pos >= BUFFER_SIZE - 1) {
-                rx_buffer_pos = 0;
-                rx_buffer[0] = '\0';
-            }
+        }
+    } else {
+        // A full buffer holds no newline, so the line is too long: drop all
+        // of it, rather than running its tail as a command
+        stats.rx_truncated++;
+        rx_buffer_pos = 0;
+        rx_buffer[0] = '\0';
+        rx_discarding = (c != '\n');
+    }
+}
+
+void USBSerial::update() {
+    tud_task();
+    
+    const bool connected = is_connected();
+    if (connected && !was_connected) {
+        stats.connects++;
+        tx_stalled = false;
+    }
+    was_connected = connected;
+    
+    send_pending();
+    
+    char chunk[64];
+    uint32_t count;
+    while ((count = tud_cdc_n_read(USB_CDC_CONSOLE, chunk, sizeof(chunk))) > 0) {
+        stats.rx_bytes += count;
+        for (uint32_t i = 0; i < count; i++) {
+            receive_char(chunk[i]);
         }
     }
-}
\ No newline at end of file
+}
@@ -5,6 +5,31 @@
 #include <stdint.h>
 #include <array>
 #include <string_view>
+#include <type_traits>
+
+// print() argument: lowercase hex, zero-padded to at least width digits
+struct Hex {
+    uint32_t value;
+    uint8_t width = 0;
+};
+
+// Console link counters, since boot or the last reset_stats()
+struct UsbStats {
+    uint32_t rx_bytes = 0;
+    uint32_t rx_lines = 0;
+    uint32_t rx_truncated = 0;      // Lines longer than the receive buffer, discarded whole
+    uint32_t tx_bytes = 0;          // Accepted by the CDC stack
+    uint32_t tx_lines = 0;
+    uint32_t tx_dropped = 0;        // Bytes lost: no host on the port, or a stalled host
+    uint32_t held_dropped = 0;      // Lines that did not fit the pending buffer
+    uint32_t tx_stalls = 0;         // Writes that had to wait for the host to read
+    uint32_t tx_timeouts = 0;       // Writes given up after TX_TIMEOUT_US
+    uint32_t tx_stall_us = 0;       // Total time spent waiting
+    uint32_t tx_stall_max_us = 0;
+    uint32_t tx_queue_max = 0;      // Most bytes waiting in the CDC TX FIFO
+    uint32_t held_max = 0;          // Most bytes in the pending buffer
+    uint32_t connects = 0;          // Host opened the port (DTR raised)
+};
 
 class USBSerial {
  private:
@@ -12,12 +37,74 @@ class USBSerial {
     static constexpr size_t BUFFER_SIZE = 256;
     std::array<char, BUFFER_SIZE> rx_buffer{};
     size_t rx_buffer_pos = 0;
+    bool rx_discarding = false;  // Skipping the rest of an over-long line
+    
+    // Lines held until a host opens the port
+    static constexpr size_t PENDING_SIZE = 256;
+    std::array<char, PENDING_SIZE> pending_buffer{};
+    size_t pending_length = 0;
+    
+    // Outgoing text is formatted straight into this buffer and sent in one
+    // write. Main loop only: the button IRQ leaves its status line to
+    // Feud::announce_presses(). Sized for the longest status line, about
+    // 390 bytes with eight ranked press timestamps and the link fields,
+    // so that it never leaves in two pieces.
+    static constexpr size_t TX_BUFFER_SIZE = 512;
+    std::array<char, TX_BUFFER_SIZE> tx_buffer{};
+    size_t tx_length = 0;
     
     using LineCallback = void (*)(std::string_view line);
     LineCallback line_callback = nullptr;
+    uint64_t line_rx_us = 0;  // time_us_64() when the current line's newline was read
+    uint64_t previous_line_rx_us = 0;
+    
+    UsbStats stats;
+    bool was_connected = false;
+    
+    // How long a write waits for a host that has stopped reading. Once one
+    // write has timed out, later writes are dropped without waiting until
+    // the host has drained the FIFO, so a command that flushes many times
+    // can't hold the loop past the watchdog.
+    static constexpr uint32_t TX_TIMEOUT_US = 500000;
+    bool tx_stalled = false;
     
     void init();
+    void receive_char(char c);
     void process_rx_buffer();
+    void hold(const char* data, size_t length, bool newline);
+    void send_pending();
+    void write_console(const char* data, size_t length);
+    
+    void put_char(char c) {
+        if (tx_length == TX_BUFFER_SIZE) flush();
+        tx_buffer[tx_length++] = c;
+    }
+    void put_text(std::string_view text);
+    void put_unsigned(uint64_t value);
+    void put_signed(int64_t value);
+    void put_hex(Hex hex);
+    
+    template <typename T>
+    static constexpr bool unsupported_argument = false;
+    
+    template <typename T>
+    void put_arg(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            put_char(value ? '1' : '0');
+        } else if constexpr (std::is_same_v<T, char>) {
+            put_char(value);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            put_signed(value);
+        } else if constexpr (std::is_integral_v<T>) {
+            put_unsigned(value);
+        } else if constexpr (std::is_same_v<T, Hex>) {
+            put_hex(value);
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            put_text(std::string_view{value});
+        } else {
+            static_assert(unsupported_argument<T>, "print() takes integers, bool, char, strings and Hex");
+        }
+    }
     
  public:
     static USBSerial& instance();
@@ -26,8 +113,37 @@ class USBSerial {
     
     void send_line(std::string_view line);
     
+    // Like send_line, but delivered once the host has connected
+    void queue_line(std::string_view line);
+    
+    bool is_connected() const;
+    
+    // Receive time of the line being handled, for time_sync; also the last command
+    uint64_t get_line_rx_us() const { return line_rx_us; }
+    
+    // Time between the current line and the one before it
+    uint64_t get_line_gap_us() const { return line_rx_us - previous_line_rx_us; }
+    
+    const UsbStats& get_stats() const { return stats; }
+    void reset_stats();
+    
     void send_data(const uint8_t* data, size_t length);
     
+    // Formats each argument by its type into the TX buffer; there is no
+    // format string, so mismatches fail to compile. Integers print in
+    // decimal, bool as 0/1. append() batches, print() also sends.
+    template <typename... Args>
+    void append(const Args&... args) {
+        (put_arg(args), ...);
+    }
+    template <typename... Args>
+    void print(const Args&... args) {
+        append(args...);
+        flush();
+    }
+    void flush();
+    
+    // Runs the USB stack and reads console input; call from the main loop
     void update();
 };
 
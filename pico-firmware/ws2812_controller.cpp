@@ -8,24 +8,11 @@
 #include "hardware/irq.h"
 #include "pico/stdlib.h"
 #include "pico/time.h"
-
-// PIO program for WS2812 timing
-// This generates the precise timing required for WS2812B LEDs
-static const uint16_t ws2812_program[] = {
-    //     .wrap_target
-    0x6221,  //  0: out    x, 1            side 0 [2]
-    0x1023,  //  1: jmp    !x, 3           side 1 [0]
-    0x1400,  //  2: jmp    0               side 1 [4]
-    0x4001,  //  3: nop                    side 0 [4]
-    //     .wrap
-};
-
-static const struct pio_program ws2812_pio_program = {
-    .instructions = ws2812_program,
-    .length = 4,
-    .origin = -1,
-    .pio_version = 0,
-};
+#include "clock_governor.h"
+#include "color_blend.h"
+#include "hot_path.h"
+#include "effect_vm.h"
+#include "feud.h"
 
 // Static instance pointer for singleton
 static WS2812Controller* ws2812_instance = nullptr;
@@ -42,149 +29,274 @@ WS2812Controller& WS2812Controller::instance() {
 
 void WS2812Controller::init() {
     // Clear all buffers
+    for (auto& layer : layers) {
+        for (auto& strip_buffer : layer.pixels) {
+            strip_buffer.fill(RGB(0, 0, 0));
+        }
+    }
     for (auto& strip_buffer : led_buffers) {
-        strip_buffer.fill(RGB(0, 0, 0));
+        strip_buffer.fill(RGB16(0, 0, 0));
+    }
+    layers[BASE_LAYER].enabled = true;
+    
+    // Gradients and fades blend on the interpolator
+    ColorBlender::instance();
+    
+    // Seed the dither accumulators so neighbouring LEDs don't step in lockstep
+    for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+        for (uint i = 0; i < LEDS_PER_STRIP; i++) {
+            uint8_t seed = (strip * LEDS_PER_STRIP + i) * 167;
+            dither_error[strip][i] = RGB(seed, seed + 85, seed + 170);
+        }
     }
     
-    // Initialize PIO and DMA
-    init_pio();
-    init_dma();
+    // Every strip starts out as WS2812 until the saved config says otherwise
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        set_strip_chip(i, LedChip::WS2812);
+    }
     
     // Initial clear of all strips
     clear_all();
 }
 
-void WS2812Controller::init_pio() {
-    // Add the WS2812 program to PIO memory
-    uint offset = pio_add_program(pio, &ws2812_pio_program);
+bool WS2812Controller::set_strip_chip(uint strip, LedChip chip) {
+    if (!is_strip_valid(strip) || chip >= LedChip::COUNT) return false;
+    if (drivers[strip] && drivers[strip]->chip() == chip) return true;
+    
+    std::array<LedChip, NUM_STRIPS> chips;
+    uint pool_words = 0;
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        chips[i] = (i == strip) ? chip : get_strip_chip(i);
+        pool_words += led_driver_words(chips[i], LEDS_PER_STRIP);
+    }
+    if (pool_words > OUTPUT_POOL_WORDS) return false;
     
-    // Configure GPIO pins and state machines for each strip
-    const uint pins[NUM_STRIPS] = {
+    // Regions follow strip order, so this strip's and every later one's move
+    uint32_t* words = output_pool.data();
+    for (uint i = 0; i < NUM_STRIPS; i++) {
+        if (i >= strip) {
+            start_driver(i, chips[i], words);
+        }
+        words += led_driver_words(chips[i], LEDS_PER_STRIP);
+    }
+    
+    // The slowest strip bounds the frame rate
+    set_frame_rate(frame_rate_hz);
+    return true;
+}
+
+void WS2812Controller::start_driver(uint strip, LedChip chip, uint32_t* words) {
+    static constexpr uint data_pins[NUM_STRIPS] = {
         WS2812_PIN_STRIP_0,
         WS2812_PIN_STRIP_1
     };
+    static constexpr uint clock_pins[NUM_STRIPS] = {
+        APA102_CLOCK_PIN_STRIP_0,
+        APA102_CLOCK_PIN_STRIP_1
+    };
+    static const char* const owners[NUM_STRIPS] = {"strip0", "strip1"};
     
-    for (uint i = 0; i < NUM_STRIPS; i++) {
-        // Claim a state machine
-        sm[i] = pio_claim_unused_sm(pio, true);
-        
-        // Configure the GPIO pin
-        gpio_init(pins[i]);
-        gpio_set_dir(pins[i], GPIO_OUT);  // Set as output
-        gpio_put(pins[i], 0);             // Set initial state to low
-        pio_gpio_init(pio, pins[i]);      // Give control to PIO
-        
-        // Configure the state machine
-        pio_sm_config config = pio_get_default_sm_config();
-        
-        // Set the pin direction
-        pio_sm_set_consecutive_pindirs(pio, sm[i], pins[i], 1, true);
-        
-        // Configure side-set pins
-        sm_config_set_sideset_pins(&config, pins[i]);
-        
-        // Configure the output shift register
-        sm_config_set_out_shift(&config, false, true, 24);  // Shift left, autopull at 24 bits
-        
-        // Configure FIFO join - join RX to TX for deeper FIFO
-        sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_TX);
-        
-        // Calculate clock divider for correct timing
-        // WS2812B bit period = 1.25us, we have 5 instructions per bit
-        float div = clock_get_hz(clk_sys) / (800000 * 6);  // 800kHz * 5 instructions
-        sm_config_set_clkdiv(&config, div);
-        
-        // Set wrap points
-        sm_config_set_wrap(&config, offset + 0, offset + 3);
-        
-        // Set side-set options
-        sm_config_set_sideset(&config, 1, false, false);
+    // Hand the strip's state machine, DMA channel and pins back first
+    if (drivers[strip]) {
+        drivers[strip]->release();
+    }
+    
+    StripDrivers& available = strip_drivers[strip];
+    switch (chip) {
+        case LedChip::SK6812_RGBW:
+            drivers[strip] = &available.sk6812;
+            break;
+        case LedChip::APA102:
+            drivers[strip] = &available.apa102;
+            break;
+        default:
+            drivers[strip] = &available.ws2812;
+            break;
+    }
+    output_words[strip] = words;
+    drivers[strip]->init(data_pins[strip], clock_pins[strip], words, owners[strip]);
+}
+
+LedChip WS2812Controller::get_strip_chip(uint strip) const {
+    return (is_strip_valid(strip) && drivers[strip]) ? drivers[strip]->chip() : LedChip::WS2812;
+}
+
+uint32_t WS2812Controller::get_max_frame_rate() const {
+    uint32_t frame_us = 0;
+    for (const LedDriver* driver : drivers) {
+        if (driver) {
+            frame_us = std::max(frame_us, driver->frame_time_us(LEDS_PER_STRIP));
+        }
+    }
+    return frame_us ? std::clamp(1000000 / frame_us, MIN_FRAME_RATE_HZ, MAX_FRAME_RATE_HZ) : MAX_FRAME_RATE_HZ;
+}
+
+void WS2812Controller::update(bool force) {
+    // Frames are paced by the scheduler's hardware timer
+    FrameScheduler& scheduler = FrameScheduler::instance();
+    bool frame_due = scheduler.consume_frame();
+    
+    if (force || frame_due) {
+        const uint32_t render_start = time_us_32();
+        render();
         
-        // Initialize the state machine
-        pio_sm_init(pio, sm[i], offset, &config);
+        // Render load drives the clock governor, against the period the
+        // scheduler actually runs at (faster than frame_rate_hz while dithering)
+        last_render_us = time_us_32() - render_start;
+        ClockGovernor::instance().report_render(last_render_us, 1000000 / scheduler.get_rate());
         
-        // Enable the state machine
-        pio_sm_set_enabled(pio, sm[i], true);
+        for (uint i = 0; i < NUM_STRIPS; i++) {
+            trigger_dma_transfer(i);
+        }
     }
 }
 
-void WS2812Controller::init_dma() {
-    // Claim DMA channels for each strip
+void WS2812Controller::render(bool full) {
+    // Re-render animating layers and zones, then re-blend only if something changed
+    update_animations();
+    update_zones();
+    if (composite_dirty || full) {
+        composite();
+    }
+    
+    // Always refresh all strips
     for (uint i = 0; i < NUM_STRIPS; i++) {
-        dma_channels[i] = dma_claim_unused_channel(true);
-        
-        // Configure DMA channel
-        dma_channel_config dma_config = dma_channel_get_default_config(dma_channels[i]);
-        
-        // Transfer 32-bit words
-        channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_32);
-        
-        // Increment read address, fixed write address (PIO FIFO)
-        channel_config_set_read_increment(&dma_config, true);
-        channel_config_set_write_increment(&dma_config, false);
-        
-        // Pace transfers based on PIO TX FIFO availability
-        channel_config_set_dreq(&dma_config, pio_get_dreq(pio, sm[i], true));
-        
-        // Configure the channel
-        dma_channel_configure(
-            dma_channels[i],
-            &dma_config,
-            &pio->txf[sm[i]],           // Write to PIO TX FIFO
-            dma_buffers[i].data(),      // Read from DMA buffer
-            LEDS_PER_STRIP,             // Number of transfers
-            false                       // Don't start yet
-        );
+        prepare_dma_buffer(i);
     }
 }
 
-void WS2812Controller::update(bool force) {
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
+void HOT_PATH_FUNC(WS2812Controller::composite)() {
+    for (auto& strip_buffer : led_buffers) {
+        strip_buffer.fill(RGB16(0, 0, 0));
+    }
     
-    // Always update animations
-    update_animations();
+    for (auto& layer : layers) {
+        if (layer.enabled) {
+            blend_layer(layer);
+        }
+        layer.dirty = false;
+    }
+    composite_dirty = false;
+}
+
+// Blend one channel of the layer (s) onto the 16-bit composite (d)
+static inline uint16_t blend_channel(BlendMode mode, uint16_t d, uint8_t s, uint8_t opacity) {
+    int32_t target;
+    switch (mode) {
+        case BlendMode::ADD:
+            target = std::min(65535, d + s * 257);
+            break;
+        case BlendMode::MULTIPLY:
+            target = (d * s) / 255;
+            break;
+        case BlendMode::MAX:
+            target = std::max<int32_t>(d, s * 257);
+            break;
+        case BlendMode::NORMAL:
+        default:
+            target = s * 257;
+            break;
+    }
+    return d + ((target - d) * opacity) / 255;
+}
+
+void HOT_PATH_FUNC(WS2812Controller::blend_layer)(const Layer& layer) {
+    const uint start = layer.range_start;
+    const uint end = layer.range_end();
     
-    // Check if it's time for a frame update
-    if (force || (current_time - last_update_time) >= UPDATE_INTERVAL_MS) {
-        last_update_time = current_time;
+    for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+        if (!layer.covers_strip(strip)) continue;
         
-        // Always update all buffers
-        for (uint i = 0; i < NUM_STRIPS; i++) {
-            prepare_dma_buffer(i);
+        auto& dst = led_buffers[strip];
+        const auto& src = layer.pixels[strip];
+        
+        if (layer.blend == BlendMode::NORMAL && layer.opacity == 255) {
+            for (uint i = start; i < end; i++) {
+                dst[i] = RGB16::from_rgb(src[i]);
+            }
+            continue;
         }
-        for (uint i = 0; i < NUM_STRIPS; i++) {
-            trigger_dma_transfer(i);
-            buffers_dirty[i] = false;
+        
+        for (uint i = start; i < end; i++) {
+            dst[i] = RGB16(
+                blend_channel(layer.blend, dst[i].r, src[i].r, layer.opacity),
+                blend_channel(layer.blend, dst[i].g, src[i].g, layer.opacity),
+                blend_channel(layer.blend, dst[i].b, src[i].b, layer.opacity)
+            );
         }
     }
 }
 
-void WS2812Controller::prepare_dma_buffer(uint strip_index) {
+// Scale a 16-bit channel by brightness and reduce it to 8 bits. With dithering
+// the dropped low byte is accumulated and carried into the next frame, so the
+// time-averaged output keeps the full 16-bit resolution.
+static inline uint32_t scale_channel(uint16_t value, uint32_t scale, uint8_t* error) {
+    uint32_t scaled = (value * scale) >> 8;
+    if (!error) {
+        return scaled >> 8;
+    }
+    
+    uint32_t acc = scaled + *error;
+    *error = acc & 0xFF;
+    return std::min<uint32_t>(acc >> 8, 255);
+}
+
+void HOT_PATH_FUNC(WS2812Controller::prepare_dma_buffer)(uint strip_index) {
     if (!is_strip_valid(strip_index)) return;
     
-    // Convert RGB values to GRB format with brightness adjustment
+    const uint32_t scale = brightness_scale;
+    const auto& pixels = led_buffers[strip_index];
+    auto& errors = dither_error[strip_index];
+    
+    // Reduce to a final 8-bit pixel with brightness adjustment
+    const auto reduce = [&](uint i) {
+        if (dithering) {
+            return RGB(scale_channel(pixels[i].r, scale, &errors[i].r),
+                       scale_channel(pixels[i].g, scale, &errors[i].g),
+                       scale_channel(pixels[i].b, scale, &errors[i].b));
+        }
+        return RGB(scale_channel(pixels[i].r, scale, nullptr),
+                   scale_channel(pixels[i].g, scale, nullptr),
+                   scale_channel(pixels[i].b, scale, nullptr));
+    };
+    
+    LedDriver* driver = drivers[strip_index];
+    
+    // Packed GRB chips take the pixels straight into the DMA buffer, once
+    // the previous frame has finished reading it
+    if (uint8_t* grb = driver->grb_frame()) {
+        driver->wait_idle();
+        for (uint i = 0; i < LEDS_PER_STRIP; i++, grb += 3) {
+            const RGB p = reduce(i);
+            grb[0] = p.g;
+            grb[1] = p.r;
+            grb[2] = p.b;
+        }
+        driver->end_grb_frame(LEDS_PER_STRIP);
+        return;
+    }
+    
+    // Otherwise stage the pixels in the same buffer, then encode for the chip in place
+    static_assert(sizeof(RGB) == 3);
+    RGB* staged = reinterpret_cast<RGB*>(output_words[strip_index]);
+    driver->wait_idle();
     for (uint i = 0; i < LEDS_PER_STRIP; i++) {
-        RGB adjusted = apply_brightness(led_buffers[strip_index][i]);
-        dma_buffers[strip_index][i] = adjusted.to_grb() << 8u;  // Shift for PIO format
+        staged[i] = reduce(i);
     }
+    driver->encode(staged, LEDS_PER_STRIP);
 }
 
 void WS2812Controller::trigger_dma_transfer(uint strip_index) {
     if (!is_strip_valid(strip_index)) return;
     
-    // Wait for any previous transfer to complete
-    dma_channel_wait_for_finish_blocking(dma_channels[strip_index]);
-    
-    // Reset the transfer
-    dma_channel_set_read_addr(dma_channels[strip_index], dma_buffers[strip_index].data(), false);
-    dma_channel_set_trans_count(dma_channels[strip_index], LEDS_PER_STRIP, true);
+    drivers[strip_index]->transfer();
 }
 
 void WS2812Controller::set_led(uint strip, uint led_index, const RGB& color) {
     if (!is_led_valid(strip, led_index)) return;
     
-    led_buffers[strip][led_index] = color;
-    buffers_dirty[strip] = true;
+    layers[BASE_LAYER].pixels[strip][led_index] = color;
+    mark_layer_dirty(layers[BASE_LAYER]);
 }
 
 void WS2812Controller::set_led(uint strip, uint led_index, uint8_t r, uint8_t g, uint8_t b) {
@@ -194,8 +306,8 @@ void WS2812Controller::set_led(uint strip, uint led_index, uint8_t r, uint8_t g,
 void WS2812Controller::set_strip(uint strip, const RGB& color) {
     if (!is_strip_valid(strip)) return;
     
-    led_buffers[strip].fill(color);
-    buffers_dirty[strip] = true;
+    layers[BASE_LAYER].pixels[strip].fill(color);
+    mark_layer_dirty(layers[BASE_LAYER]);
 }
 
 void WS2812Controller::set_all(const RGB& color) {
@@ -213,202 +325,548 @@ void WS2812Controller::clear_all() {
 }
 
 void WS2812Controller::set_brightness(float new_brightness) {
+    // Brightness is applied when the DMA buffers are prepared each frame
     brightness = std::max(0.0f, std::min(1.0f, new_brightness));
-    
-    // Mark all buffers as dirty to apply new brightness
-    for (uint i = 0; i < NUM_STRIPS; i++) {
-        buffers_dirty[i] = true;
-    }
+    brightness_scale = (uint32_t)(brightness * 256.0f + 0.5f);
+}
+
+void WS2812Controller::set_dithering(bool enabled) {
+    dithering = enabled;
+    const uint32_t high_refresh = std::min(HIGH_REFRESH_RATE_HZ, get_max_frame_rate());
+    FrameScheduler::instance().set_rate(dithering ? std::max(frame_rate_hz, high_refresh) : frame_rate_hz);
+}
+
+void WS2812Controller::set_frame_rate(uint32_t hz) {
+    frame_rate_hz = std::clamp(hz, MIN_FRAME_RATE_HZ, get_max_frame_rate());
+    set_dithering(dithering);
 }
 
 void WS2812Controller::set_range(uint strip, uint start_index, uint count, const RGB& color) {
     if (!is_strip_valid(strip)) return;
     
+    auto& pixels = layers[BASE_LAYER].pixels[strip];
     uint end_index = std::min(start_index + count, (uint)LEDS_PER_STRIP);
     for (uint i = start_index; i < end_index; i++) {
-        led_buffers[strip][i] = color;
+        pixels[i] = color;
     }
-    buffers_dirty[strip] = true;
+    mark_layer_dirty(layers[BASE_LAYER]);
 }
 
 void WS2812Controller::set_gradient(uint strip, uint start_index, uint count, const RGB& start_color, const RGB& end_color) {
     if (!is_strip_valid(strip) || count == 0) return;
     
+    auto& pixels = layers[BASE_LAYER].pixels[strip];
     uint end_index = std::min(start_index + count, (uint)LEDS_PER_STRIP);
     uint actual_count = end_index - start_index;
     
-    for (uint i = 0; i < actual_count; i++) {
-        float ratio = (float)i / (float)(actual_count - 1);
-        RGB interpolated(
-            start_color.r + (end_color.r - start_color.r) * ratio,
-            start_color.g + (end_color.g - start_color.g) * ratio,
-            start_color.b + (end_color.b - start_color.b) * ratio
-        );
-        led_buffers[strip][start_index + i] = interpolated;
-    }
-    buffers_dirty[strip] = true;
+    ColorBlender::instance().gradient(&pixels[start_index], actual_count, start_color, end_color);
+    mark_layer_dirty(layers[BASE_LAYER]);
 }
 
 void WS2812Controller::set_animation(AnimationMode mode, uint32_t speed_ms) {
-    current_animation = mode;
-    animation_speed = speed_ms;
-    animation_start_time = to_ms_since_boot(get_absolute_time());
+    set_layer_animation(BASE_LAYER, mode, speed_ms);
 }
 
 void WS2812Controller::set_animation_colors(const RGB& primary, const RGB& secondary) {
-    primary_color = primary;
-    secondary_color = secondary;
+    set_layer_colors(BASE_LAYER, primary, secondary);
+}
+
+void WS2812Controller::set_layer_enabled(uint layer, bool enabled) {
+    if (!is_layer_valid(layer) || layer == BASE_LAYER) return;
+    
+    layers[layer].enabled = enabled;
+    composite_dirty = true;
+}
+
+void WS2812Controller::set_layer_animation(uint layer, AnimationMode mode, uint32_t speed_ms) {
+    if (!is_layer_valid(layer)) return;
+    
+    Layer& l = layers[layer];
+    l.animation = mode;
+    l.animation_speed = std::clamp(speed_ms, MIN_ANIMATION_SPEED_MS, MAX_ANIMATION_SPEED_MS);
+    l.animation_start_time = FrameScheduler::instance().get_frame_time_ms();
+    l.enabled = true;
+    mark_layer_dirty(l);
+}
+
+void WS2812Controller::set_layer_colors(uint layer, const RGB& primary, const RGB& secondary) {
+    if (!is_layer_valid(layer)) return;
+    
+    layers[layer].primary_color = primary;
+    layers[layer].secondary_color = secondary;
+}
+
+void WS2812Controller::set_layer_blend(uint layer, BlendMode mode, uint8_t opacity) {
+    if (!is_layer_valid(layer)) return;
+    
+    layers[layer].blend = mode;
+    layers[layer].opacity = opacity;
+    composite_dirty = true;
+}
+
+void WS2812Controller::set_layer_mask(uint layer, uint8_t strip_mask, uint start_index, uint count) {
+    if (!is_layer_valid(layer)) return;
+    
+    Layer& l = layers[layer];
+    l.strip_mask = strip_mask & ((1u << NUM_STRIPS) - 1);
+    l.range_start = std::min(start_index, (uint)LEDS_PER_STRIP);
+    l.range_count = std::min(count, LEDS_PER_STRIP - l.range_start);
+    mark_layer_dirty(l);
+}
+
+void WS2812Controller::set_layer_fill(uint layer, const RGB& color) {
+    if (!is_layer_valid(layer)) return;
+    
+    fill_layer(layers[layer], color);
+    layers[layer].enabled = true;
+}
+
+void WS2812Controller::set_layer_effect(uint layer, uint slot) {
+    if (!is_layer_valid(layer) || slot >= MAX_EFFECTS) return;
+    
+    layers[layer].effect_slot = slot;
+    set_layer_animation(layer, AnimationMode::EFFECT, layers[layer].animation_speed);
+}
+
+void HOT_PATH_FUNC(WS2812Controller::fill_layer)(Layer& layer, const RGB& color) {
+    for (auto& strip_buffer : layer.pixels) {
+        strip_buffer.fill(color);
+    }
+    mark_layer_dirty(layer);
 }
 
+void HOT_PATH_FUNC(WS2812Controller::mark_layer_dirty)(Layer& layer) {
+    layer.dirty = true;
+    composite_dirty = true;
+}
 
 RGB WS2812Controller::get_led(uint strip, uint led_index) const {
     if (!is_led_valid(strip, led_index)) return RGB(0, 0, 0);
-    return led_buffers[strip][led_index];
+    return layers[BASE_LAYER].pixels[strip][led_index];
+}
+
+void HOT_PATH_FUNC(WS2812Controller::update_animations)() {
+    uint32_t current_time = FrameScheduler::instance().get_frame_time_ms();
+    
+    // Static layers keep their pixels; only animating layers are re-rendered
+    for (auto& layer : layers) {
+        if (!layer.enabled || layer.animation == AnimationMode::STATIC) continue;
+        
+        uint32_t elapsed_ms = current_time - layer.animation_start_time;
+        
+        switch (layer.animation) {
+            case AnimationMode::RAINBOW:
+                animate_rainbow(layer, elapsed_ms);
+                break;
+            case AnimationMode::CHASE:
+                animate_chase(layer, elapsed_ms);
+                break;
+            case AnimationMode::PULSE:
+                animate_pulse(layer, elapsed_ms);
+                break;
+            case AnimationMode::SPARKLE:
+                animate_sparkle(layer, elapsed_ms);
+                break;
+            case AnimationMode::FADE:
+                animate_fade(layer, elapsed_ms);
+                break;
+            case AnimationMode::EFFECT:
+                animate_effect(layer, elapsed_ms);
+                break;
+            default:
+                break;
+        }
+    }
 }
 
-RGB WS2812Controller::apply_brightness(const RGB& color) const {
+// Speeds are clamped, so the period and the blend alpha stay in 32 bits
+static_assert((uint64_t)MAX_ANIMATION_SPEED_MS * 2 * ColorBlender::ALPHA_ONE <= UINT32_MAX);
+
+static inline RGB pulse_color(const RGB& color, uint32_t elapsed_ms, uint32_t speed) {
+    float phase = (float)(elapsed_ms % (speed * 2)) / (float)speed;
+    float intensity = (phase < 1.0f) ? phase : (2.0f - phase);
+    
     return RGB(
-        color.r * brightness,
-        color.g * brightness,
-        color.b * brightness
+        color.r * intensity,
+        color.g * intensity,
+        color.b * intensity
     );
 }
 
-void WS2812Controller::update_animations() {
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
-    uint32_t elapsed_ms = current_time - animation_start_time;
+static inline RGB fade_color(const RGB& primary_color, const RGB& secondary_color, uint32_t elapsed_ms, uint32_t speed) {
+    const ColorBlender& blender = ColorBlender::instance();
+    const uint32_t phase_ms = elapsed_ms % (speed * 2);
     
-    switch (current_animation) {
-        case AnimationMode::STATIC:
-            // For STATIC mode, mark all buffers as dirty to force continuous updates
-            for (uint i = 0; i < NUM_STRIPS; i++) {
-                buffers_dirty[i] = true;
-            }
-            break;
-        case AnimationMode::RAINBOW:
-            animate_rainbow(elapsed_ms);
-            break;
-        case AnimationMode::CHASE:
-            animate_chase(elapsed_ms);
-            break;
-        case AnimationMode::PULSE:
-            animate_pulse(elapsed_ms);
-            break;
-        case AnimationMode::SPARKLE:
-            animate_sparkle(elapsed_ms);
-            break;
-        case AnimationMode::FADE:
-            animate_fade(elapsed_ms);
-            break;
-        default:
-            break;
+    // Primary to secondary over the first half, then back
+    if (phase_ms < speed) {
+        return blender.blend(primary_color, secondary_color, phase_ms * ColorBlender::ALPHA_ONE / speed);
     }
+    return blender.blend(secondary_color, primary_color, (phase_ms - speed) * ColorBlender::ALPHA_ONE / speed);
 }
 
-void WS2812Controller::animate_rainbow(uint32_t elapsed_ms) {
-    uint32_t phase = (elapsed_ms / animation_speed) % 256;
+void HOT_PATH_FUNC(WS2812Controller::animate_rainbow)(Layer& layer, uint32_t elapsed_ms) {
+    uint32_t phase = (elapsed_ms / layer.animation_speed) % 256;
+    const uint start = layer.range_start;
+    const uint count = std::max(layer.range_end() - start, 1u);
     
     for (uint strip = 0; strip < NUM_STRIPS; strip++) {
-        for (uint i = 0; i < LEDS_PER_STRIP; i++) {
-            uint32_t hue = (phase + (i * 256 / LEDS_PER_STRIP)) & 0xFF;
-            
-            // Simple HSV to RGB conversion (S=1, V=1)
-            uint8_t region = hue / 43;
-            uint8_t remainder = (hue - (region * 43)) * 6;
-            
-            uint8_t p = 0;
-            uint8_t q = (255 * (255 - remainder)) / 255;
-            uint8_t t = (255 * remainder) / 255;
-            
-            switch (region) {
-                case 0: led_buffers[strip][i] = RGB(255, t, p); break;
-                case 1: led_buffers[strip][i] = RGB(q, 255, p); break;
-                case 2: led_buffers[strip][i] = RGB(p, 255, t); break;
-                case 3: led_buffers[strip][i] = RGB(p, q, 255); break;
-                case 4: led_buffers[strip][i] = RGB(t, p, 255); break;
-                default: led_buffers[strip][i] = RGB(255, p, q); break;
-            }
+        if (!layer.covers_strip(strip)) continue;
+        
+        auto& pixels = layer.pixels[strip];
+        for (uint i = 0; i < count && start + i < LEDS_PER_STRIP; i++) {
+            pixels[start + i] = rainbow_color((phase + (i * 256 / count)) & 0xFF);
         }
-        buffers_dirty[strip] = true;
     }
+    mark_layer_dirty(layer);
 }
 
-void WS2812Controller::animate_chase(uint32_t elapsed_ms) {
-    uint32_t position = (elapsed_ms / animation_speed) % LEDS_PER_STRIP;
+void HOT_PATH_FUNC(WS2812Controller::animate_chase)(Layer& layer, uint32_t elapsed_ms) {
+    const uint start = layer.range_start;
+    const uint count = std::max(layer.range_end() - start, 1u);
+    uint32_t position = (elapsed_ms / layer.animation_speed) % count;
     
     for (uint strip = 0; strip < NUM_STRIPS; strip++) {
-        for (uint i = 0; i < LEDS_PER_STRIP; i++) {
-            if (i == position || i == (position + 1) % LEDS_PER_STRIP) {
-                led_buffers[strip][i] = primary_color;
+        if (!layer.covers_strip(strip)) continue;
+        
+        auto& pixels = layer.pixels[strip];
+        for (uint i = 0; i < count && start + i < LEDS_PER_STRIP; i++) {
+            if (i == position || i == (position + 1) % count) {
+                pixels[start + i] = layer.primary_color;
             } else {
-                led_buffers[strip][i] = secondary_color;
+                pixels[start + i] = layer.secondary_color;
             }
         }
-        buffers_dirty[strip] = true;
     }
+    mark_layer_dirty(layer);
 }
 
-void WS2812Controller::animate_pulse(uint32_t elapsed_ms) {
-    float phase = (float)(elapsed_ms % (animation_speed * 2)) / (float)animation_speed;
-    float intensity = (phase < 1.0f) ? phase : (2.0f - phase);
-    
-    RGB pulsed_color(
-        primary_color.r * intensity,
-        primary_color.g * intensity,
-        primary_color.b * intensity
-    );
-    
-    set_all(pulsed_color);
+void HOT_PATH_FUNC(WS2812Controller::animate_pulse)(Layer& layer, uint32_t elapsed_ms) {
+    fill_layer(layer, pulse_color(layer.primary_color, elapsed_ms, layer.animation_speed));
 }
 
-void WS2812Controller::animate_sparkle(uint32_t elapsed_ms) {
+void HOT_PATH_FUNC(WS2812Controller::animate_sparkle)(Layer& layer, uint32_t elapsed_ms) {
+    const uint start = layer.range_start;
+    const uint end = layer.range_end();
+    if (end <= start) return;
+    
     // Random sparkle effect
-    if ((elapsed_ms / animation_speed) % 2 == 0) {
+    if ((elapsed_ms / layer.animation_speed) % 2 == 0) {
         // Add random sparkles
         for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+            if (!layer.covers_strip(strip)) continue;
             for (uint i = 0; i < 3; i++) {  // Add 3 sparkles per strip
-                uint pos = rand() % LEDS_PER_STRIP;
-                led_buffers[strip][pos] = primary_color;
+                uint pos = start + next_random() % (end - start);
+                layer.pixels[strip][pos] = layer.primary_color;
             }
-            buffers_dirty[strip] = true;
         }
     } else {
         // Fade all LEDs
         for (uint strip = 0; strip < NUM_STRIPS; strip++) {
-            for (uint i = 0; i < LEDS_PER_STRIP; i++) {
-                led_buffers[strip][i] = RGB(
-                    led_buffers[strip][i].r * 0.9f,
-                    led_buffers[strip][i].g * 0.9f,
-                    led_buffers[strip][i].b * 0.9f
+            if (!layer.covers_strip(strip)) continue;
+            auto& pixels = layer.pixels[strip];
+            for (uint i = start; i < end; i++) {
+                pixels[i] = RGB(
+                    pixels[i].r * 0.9f,
+                    pixels[i].g * 0.9f,
+                    pixels[i].b * 0.9f
                 );
             }
-            buffers_dirty[strip] = true;
         }
     }
+    mark_layer_dirty(layer);
 }
 
-void WS2812Controller::animate_fade(uint32_t elapsed_ms) {
-    float phase = (float)(elapsed_ms % (animation_speed * 2)) / (float)(animation_speed * 2);
+void HOT_PATH_FUNC(WS2812Controller::animate_effect)(Layer& layer, uint32_t elapsed_ms) {
+    const EffectVM& vm = EffectVM::instance();
+    if (!vm.is_loaded(layer.effect_slot)) return;
     
-    RGB faded_color;
-    if (phase < 0.5f) {
-        // Fade from primary to secondary
-        float ratio = phase * 2.0f;
-        faded_color = RGB(
-            primary_color.r + (secondary_color.r - primary_color.r) * ratio,
-            primary_color.g + (secondary_color.g - primary_color.g) * ratio,
-            primary_color.b + (secondary_color.b - primary_color.b) * ratio
-        );
-    } else {
-        // Fade from secondary to primary
-        float ratio = (phase - 0.5f) * 2.0f;
-        faded_color = RGB(
-            secondary_color.r + (primary_color.r - secondary_color.r) * ratio,
-            secondary_color.g + (primary_color.g - secondary_color.g) * ratio,
-            secondary_color.b + (primary_color.b - secondary_color.b) * ratio
-        );
+    const uint start = layer.range_start;
+    const uint end = layer.range_end();
+    if (end <= start) return;
+    
+    EffectInputs inputs{0, elapsed_ms, Feud::instance().get_time_remaining(), end - start};
+    for (uint strip = 0; strip < NUM_STRIPS; strip++) {
+        if (!layer.covers_strip(strip)) continue;
+        
+        inputs.strip = strip;
+        vm.render(layer.effect_slot, inputs, &layer.pixels[strip][start], end - start);
     }
+    mark_layer_dirty(layer);
+}
+
+void HOT_PATH_FUNC(WS2812Controller::animate_fade)(Layer& layer, uint32_t elapsed_ms) {
+    fill_layer(layer, fade_color(layer.primary_color, layer.secondary_color, elapsed_ms, layer.animation_speed));
+}
+
+RGB ZoneRun::color_at(uint offset) const {
+    if (is_solid() || length < 2) return start_color;
+    if (offset + 1 >= length) return end_color;
+    
+    const uint alpha = ColorBlender::ramp_alpha(offset, ColorBlender::ramp_step(length));
+    return ColorBlender::instance().blend(start_color, end_color, alpha);
+}
+
+// Part of a run, with gradient end points re-derived for the sub-range
+static ZoneRun sub_run(const ZoneRun& run, uint offset, uint length) {
+    ZoneRun part;
+    part.length = length;
+    part.start_color = run.color_at(offset);
+    part.end_color = run.color_at(offset + length - 1);
+    return part;
+}
+
+bool WS2812Controller::define_zone(std::string_view name, const ZoneRange* ranges, uint count) {
+    if (name.empty() || name.size() > ZONE_NAME_MAX || count == 0 || count > MAX_ZONE_RANGES) return false;
+    
+    uint length = 0;
+    for (uint i = 0; i < count; i++) {
+        const ZoneRange& range = ranges[i];
+        if (!is_strip_valid(range.strip) || range.count == 0 || range.start + range.count > LEDS_PER_STRIP) {
+            return false;
+        }
+        length += range.count;
+    }
+    
+    // Redefining a zone keeps its slot but drops its content
+    int index = find_zone(name);
+    if (index < 0) {
+        for (uint i = 0; i < MAX_ZONES && index < 0; i++) {
+            if (!zones[i].in_use()) index = i;
+        }
+        if (index < 0) return false;
+    }
+    
+    Zone& zone = zones[index];
+    zone = Zone{};
+    std::copy(name.begin(), name.end(), zone.name.begin());
+    std::copy(ranges, ranges + count, zone.ranges.begin());
+    zone.range_count = count;
+    zone.length = length;
+    return true;
+}
+
+bool WS2812Controller::delete_zone(std::string_view name) {
+    const int index = find_zone(name);
+    if (index < 0) return false;
+    
+    // Its LEDs keep their last colors in the base layer
+    zones[index] = Zone{};
+    return true;
+}
+
+int WS2812Controller::find_zone(std::string_view name) const {
+    for (uint i = 0; i < MAX_ZONES; i++) {
+        if (zones[i].in_use() && zones[i].get_name() == name) return i;
+    }
+    return -1;
+}
+
+bool WS2812Controller::set_zone_fill(uint zone, uint offset, uint count, const RGB& color) {
+    if (!is_zone_valid(zone)) return false;
     
-    set_all(faded_color);
+    ZoneRun run;
+    run.start_color = run.end_color = color;
+    zones[zone].animation = AnimationMode::STATIC;
+    return write_zone_run(zones[zone], offset, count, run);
 }
 
+bool WS2812Controller::set_zone_gradient(uint zone, uint offset, uint count, const RGB& start_color, const RGB& end_color) {
+    if (!is_zone_valid(zone)) return false;
+    
+    ZoneRun run;
+    run.start_color = start_color;
+    run.end_color = end_color;
+    zones[zone].animation = AnimationMode::STATIC;
+    return write_zone_run(zones[zone], offset, count, run);
+}
+
+bool WS2812Controller::set_zone_animation(uint zone, AnimationMode mode, uint32_t speed_ms, const RGB& primary, const RGB& secondary) {
+    // Sparkle and effects produce per-LED colors, which runs cannot represent
+    if (!is_zone_valid(zone) || mode == AnimationMode::SPARKLE || mode == AnimationMode::EFFECT) return false;
+    
+    Zone& z = zones[zone];
+    z.animation = mode;
+    z.animation_speed = std::clamp(speed_ms, MIN_ANIMATION_SPEED_MS, MAX_ANIMATION_SPEED_MS);
+    z.animation_start_time = FrameScheduler::instance().get_frame_time_ms();
+    z.primary_color = primary;
+    z.secondary_color = secondary;
+    
+    if (mode == AnimationMode::STATIC) {
+        return set_zone_fill(zone, 0, z.length, primary);
+    }
+    return true;
+}
+
+bool WS2812Controller::write_zone_run(Zone& zone, uint offset, uint count, const ZoneRun& run) {
+    offset = std::min<uint>(offset, zone.length);
+    count = std::min<uint>(count, zone.length - offset);
+    if (count == 0) return true;
+    
+    // A zone without content starts out black
+    if (zone.run_count == 0) {
+        zone.runs[0] = ZoneRun{zone.length, RGB(), RGB()};
+        zone.run_count = 1;
+    }
+    
+    // Runs before the new one, the new one, then runs after it; each old
+    // run contributes at most one piece on either side
+    std::array<ZoneRun, MAX_ZONE_RUNS + 2> merged;
+    uint merged_count = 0;
+    const uint end = offset + count;
+    
+    auto append = [&](const ZoneRun& piece) {
+        ZoneRun* last = merged_count ? &merged[merged_count - 1] : nullptr;
+        if (last && piece.is_solid() && last->is_solid() && last->start_color == piece.start_color) {
+            last->length += piece.length;
+        } else {
+            merged[merged_count++] = piece;
+        }
+    };
+    
+    uint pos = 0;
+    for (uint i = 0; i < zone.run_count && pos < offset; i++) {
+        const ZoneRun& old = zone.runs[i];
+        append(sub_run(old, 0, std::min<uint>(old.length, offset - pos)));
+        pos += old.length;
+    }
+    
+    ZoneRun inserted = run;
+    inserted.length = count;
+    append(inserted);
+    
+    pos = 0;
+    for (uint i = 0; i < zone.run_count; i++) {
+        const ZoneRun& old = zone.runs[i];
+        const uint old_end = pos + old.length;
+        if (old_end > end) {
+            const uint from = std::max(pos, end);
+            append(sub_run(old, from - pos, old_end - from));
+        }
+        pos = old_end;
+        
+        if (merged_count > MAX_ZONE_RUNS) return false;
+    }
+    
+    set_zone_runs(zone, merged.data(), merged_count);
+    return true;
+}
+
+void WS2812Controller::set_zone_runs(Zone& zone, const ZoneRun* runs, uint count) {
+    // Dirty check over runs rather than LEDs
+    if (count == zone.run_count && std::equal(runs, runs + count, zone.runs.begin())) return;
+    
+    std::copy(runs, runs + count, zone.runs.begin());
+    zone.run_count = count;
+    zone.dirty = true;
+}
+
+void HOT_PATH_FUNC(WS2812Controller::animate_zone)(Zone& zone, uint32_t now_ms) {
+    const uint32_t elapsed_ms = now_ms - zone.animation_start_time;
+    const uint32_t speed = zone.animation_speed;
+    const uint length = zone.length;
+    
+    std::array<ZoneRun, MAX_ZONE_RUNS> frame;
+    uint count = 0;
+    
+    switch (zone.animation) {
+        case AnimationMode::PULSE: {
+            const RGB color = pulse_color(zone.primary_color, elapsed_ms, speed);
+            frame[count++] = ZoneRun{(uint16_t)length, color, color};
+            break;
+        }
+        case AnimationMode::FADE: {
+            const RGB color = fade_color(zone.primary_color, zone.secondary_color, elapsed_ms, speed);
+            frame[count++] = ZoneRun{(uint16_t)length, color, color};
+            break;
+        }
+        case AnimationMode::CHASE: {
+            // Two lit LEDs, wrapping from the zone's end to its start
+            const RGB& lit = zone.primary_color;
+            const RGB& unlit = zone.secondary_color;
+            const uint position = (elapsed_ms / speed) % length;
+            if (length <= 2) {
+                frame[count++] = ZoneRun{(uint16_t)length, lit, lit};
+            } else if (position == length - 1) {
+                frame[count++] = ZoneRun{1, lit, lit};
+                frame[count++] = ZoneRun{(uint16_t)(length - 2), unlit, unlit};
+                frame[count++] = ZoneRun{1, lit, lit};
+            } else {
+                if (position > 0) frame[count++] = ZoneRun{(uint16_t)position, unlit, unlit};
+                frame[count++] = ZoneRun{2, lit, lit};
+                if (position + 2 < length) frame[count++] = ZoneRun{(uint16_t)(length - position - 2), unlit, unlit};
+            }
+            break;
+        }
+        case AnimationMode::RAINBOW: {
+            // Colors are linear in hue within a region, so one gradient run
+            // per region; the hue wraps at most once over the zone
+            const uint32_t phase = (elapsed_ms / speed) % 256;
+            uint run_start = 0;
+            uint32_t run_region = phase / 43;
+            for (uint i = 1; i <= length && count < MAX_ZONE_RUNS; i++) {
+                const uint32_t region = (i < length) ? ((phase + (i * 256 / length)) & 0xFF) / 43 : UINT32_MAX;
+                if (region == run_region) continue;
+                
+                const RGB first = rainbow_color((phase + (run_start * 256 / length)) & 0xFF);
+                const RGB last = rainbow_color((phase + ((i - 1) * 256 / length)) & 0xFF);
+                frame[count++] = ZoneRun{(uint16_t)(i - run_start), first, last};
+                run_start = i;
+                run_region = region;
+            }
+            break;
+        }
+        default:
+            return;
+    }
+    
+    set_zone_runs(zone, frame.data(), count);
+}
+
+void HOT_PATH_FUNC(WS2812Controller::expand_zone)(const Zone& zone) {
+    auto& pixels = layers[BASE_LAYER].pixels;
+    uint range = 0;
+    uint index = 0;
+    
+    const ColorBlender& blender = ColorBlender::instance();
+    
+    for (uint r = 0; r < zone.run_count; r++) {
+        const ZoneRun& run = zone.runs[r];
+        const bool solid = run.is_solid();
+        const uint32_t step = ColorBlender::ramp_step(run.length);
+        
+        for (uint i = 0; i < run.length; i++) {
+            while (index >= zone.ranges[range].count) {
+                range++;
+                index = 0;
+            }
+            const ZoneRange& target = zone.ranges[range];
+            RGB color = run.start_color;
+            if (!solid) {
+                color = (i + 1 == run.length) ? run.end_color
+                                              : blender.blend(run.start_color, run.end_color, ColorBlender::ramp_alpha(i, step));
+            }
+            pixels[target.strip][target.start + index] = color;
+            index++;
+        }
+    }
+}
+
+void HOT_PATH_FUNC(WS2812Controller::update_zones)() {
+    const uint32_t now_ms = FrameScheduler::instance().get_frame_time_ms();
+    
+    // Anything else drawing into the base layer this frame covers zones too
+    const bool base_redrawn = layers[BASE_LAYER].dirty;
+    
+    for (auto& zone : zones) {
+        if (!zone.in_use()) continue;
+        
+        if (zone.animation != AnimationMode::STATIC) {
+            animate_zone(zone, now_ms);
+        }
+        if (zone.run_count > 0 && (zone.dirty || base_redrawn)) {
+            expand_zone(zone);
+            zone.dirty = false;
+            mark_layer_dirty(layers[BASE_LAYER]);
+        }
+    }
+}
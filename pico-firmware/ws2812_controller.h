@@ -3,11 +3,15 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
 #include <array>
+#include <string_view>
 
 #include "hardware/dma.h"
 #include "hardware/pio.h"
 #include "pico/stdlib.h"
+#include "frame_scheduler.h"
+#include "led_driver.h"
 
 // WS2812B Configuration
 constexpr uint NUM_STRIPS = 2;
@@ -16,7 +20,18 @@ constexpr uint TOTAL_LEDS = NUM_STRIPS * LEDS_PER_STRIP;
 
 // GPIO pin definitions for WS2812B strips
 constexpr uint WS2812_PIN_STRIP_0 = 7;   // First strip
-constexpr uint WS2812_PIN_STRIP_1 = 6;   // Second strip (pin 7 used for PLAYER_B_LED, pin 8 for level shifter)
+constexpr uint WS2812_PIN_STRIP_1 = 6;   // Second strip (pin 8 used for level shifter)
+
+// Clock pins for strips driven as APA102; the data pins above carry DIN
+constexpr uint APA102_CLOCK_PIN_STRIP_0 = 5;
+constexpr uint APA102_CLOCK_PIN_STRIP_1 = 4;
+
+// Output enable of the strips' level shifter, driven high at boot
+constexpr uint LEVEL_SHIFTER_ENABLE_PIN = 8;
+
+// Strips that may run a chip wider than packed GRB (SK6812, APA102) at the
+// same time; the output buffers of all others take 3 bytes per LED
+constexpr uint MAX_WIDE_STRIPS = 1;
 
 // Timing constants for WS2812B (in nanoseconds)
 constexpr uint32_t WS2812_T0H_NS = 400;
@@ -25,6 +40,10 @@ constexpr uint32_t WS2812_T1H_NS = 800;
 constexpr uint32_t WS2812_T1L_NS = 450;
 constexpr uint32_t WS2812_RESET_NS = 50000;  // 50us reset
 
+// Animation speed bounds; pulse and fade cycle over twice the speed
+constexpr uint32_t MIN_ANIMATION_SPEED_MS = 1;
+constexpr uint32_t MAX_ANIMATION_SPEED_MS = 60000;
+
 // Color structure for RGB values
 struct RGB {
     uint8_t r;
@@ -38,8 +57,45 @@ struct RGB {
     constexpr uint32_t to_grb() const {
         return ((uint32_t)g << 16) | ((uint32_t)r << 8) | (uint32_t)b;
     }
+    
+    constexpr bool operator==(const RGB&) const = default;
+};
+
+// 16-bit per channel color used for compositing and output
+struct RGB16 {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+    
+    constexpr RGB16() : r(0), g(0), b(0) {}
+    constexpr RGB16(uint16_t red, uint16_t green, uint16_t blue) : r(red), g(green), b(blue) {}
+    
+    // Expand 8-bit color so that 255 maps to full scale
+    static constexpr RGB16 from_rgb(const RGB& color) {
+        return RGB16(color.r * 257, color.g * 257, color.b * 257);
+    }
 };
 
+// Simple HSV to RGB conversion (S=1, V=1); linear in hue within each of
+// the six regions
+constexpr RGB rainbow_color(uint32_t hue) {
+    uint8_t region = hue / 43;
+    uint8_t remainder = (hue - (region * 43)) * 6;
+    
+    uint8_t p = 0;
+    uint8_t q = (255 * (255 - remainder)) / 255;
+    uint8_t t = (255 * remainder) / 255;
+    
+    switch (region) {
+        case 0: return RGB(255, t, p);
+        case 1: return RGB(q, 255, p);
+        case 2: return RGB(p, 255, t);
+        case 3: return RGB(p, q, 255);
+        case 4: return RGB(t, p, 255);
+        default: return RGB(255, p, q);
+    }
+}
+
 // Animation modes for LED effects
 enum class AnimationMode {
     STATIC,
@@ -47,56 +103,180 @@ enum class AnimationMode {
     RAINBOW,
     CHASE,
     PULSE,
-    SPARKLE
+    SPARKLE,
+    EFFECT      // Uploaded bytecode program, see EffectVM
+};
+
+// Compositor layers, blended bottom (0) to top
+constexpr uint MAX_LAYERS = 4;
+constexpr uint BASE_LAYER = 0;
+
+// How a layer is combined with the layers beneath it
+enum class BlendMode {
+    NORMAL,     // Replace, weighted by opacity
+    ADD,        // Saturating add
+    MULTIPLY,   // Darken by layer color
+    MAX         // Per-channel lighten
+};
+
+struct Layer {
+    bool enabled = false;
+    bool dirty = true;
+    
+    // Animation state
+    AnimationMode animation = AnimationMode::STATIC;
+    uint32_t animation_start_time = 0;  // Frame time base, see FrameScheduler
+    uint32_t animation_speed = 100;  // ms per animation step
+    RGB primary_color = RGB(0, 0, 0);
+    RGB secondary_color = RGB(0, 0, 0);
+    uint8_t effect_slot = 0;  // EffectVM program for AnimationMode::EFFECT
+    
+    // Compositing
+    BlendMode blend = BlendMode::NORMAL;
+    uint8_t opacity = 255;
+    uint8_t strip_mask = (1u << NUM_STRIPS) - 1;
+    uint range_start = 0;
+    uint range_count = LEDS_PER_STRIP;
+    
+    std::array<std::array<RGB, LEDS_PER_STRIP>, NUM_STRIPS> pixels;
+    
+    bool covers_strip(uint strip) const { return strip_mask & (1u << strip); }
+    uint range_end() const { return range_start + std::min(range_count, LEDS_PER_STRIP - range_start); }
+};
+
+// Named zones map a physical section (podium, board row) onto ranges of the
+// strips, addressed as one contiguous run of LEDs in range order
+constexpr uint MAX_ZONES = 8;
+constexpr uint MAX_ZONE_RANGES = 4;
+constexpr uint MAX_ZONE_RUNS = 16;
+constexpr size_t ZONE_NAME_MAX = 15;
+
+struct ZoneRange {
+    uint8_t strip;
+    uint8_t start;
+    uint8_t count;
+};
+
+// Run-length segment of zone content; solid when both colors are equal,
+// otherwise a linear gradient over the run
+struct ZoneRun {
+    uint16_t length = 0;
+    RGB start_color;
+    RGB end_color;
+    
+    bool is_solid() const { return start_color == end_color; }
+    RGB color_at(uint offset) const;
+    bool operator==(const ZoneRun&) const = default;
+};
+
+// Zone content is kept as runs covering the whole zone and expanded into
+// the base layer only when it changes, so solid fills cost O(runs) to set
+// and to compare. Animations are rendered into runs every frame the same way.
+struct Zone {
+    std::array<char, ZONE_NAME_MAX + 1> name{};
+    std::array<ZoneRange, MAX_ZONE_RANGES> ranges{};
+    uint8_t range_count = 0;
+    uint16_t length = 0;  // LEDs over all ranges
+    
+    std::array<ZoneRun, MAX_ZONE_RUNS> runs{};
+    uint8_t run_count = 0;  // No runs: the zone does not draw
+    bool dirty = false;
+    
+    AnimationMode animation = AnimationMode::STATIC;
+    uint32_t animation_start_time = 0;
+    uint32_t animation_speed = 100;
+    RGB primary_color;
+    RGB secondary_color;
+    
+    bool in_use() const { return name[0] != '\0'; }
+    std::string_view get_name() const { return name.data(); }
 };
 
 class WS2812Controller {
 private:
     bool initialized = false;
     
-    // PIO and DMA resources
-    PIO pio = pio0;
-    uint sm[NUM_STRIPS];  // State machines for each strip
-    int dma_channels[NUM_STRIPS];  // DMA channels for each strip
+    // Output drivers; each strip runs one of its drivers at a time
+    struct StripDrivers {
+        WS2812Driver ws2812;
+        SK6812Driver sk6812;
+        APA102Driver apa102;
+    };
+    std::array<StripDrivers, NUM_STRIPS> strip_drivers;
+    std::array<LedDriver*, NUM_STRIPS> drivers{};
     
-    // LED buffers - one per strip
-    std::array<std::array<RGB, LEDS_PER_STRIP>, NUM_STRIPS> led_buffers;
-    std::array<std::array<uint32_t, LEDS_PER_STRIP>, NUM_STRIPS> dma_buffers;
+    // Layer stack, composited at 16 bits per channel into led_buffers - one per strip
+    std::array<Layer, MAX_LAYERS> layers;
+    std::array<Zone, MAX_ZONES> zones;
+    std::array<std::array<RGB16, LEDS_PER_STRIP>, NUM_STRIPS> led_buffers;
+    
+    // Every strip's output words, laid out in strip order by the chip it
+    // runs: packed GRB for WS2812, and the wider formats' extra for at most
+    // MAX_WIDE_STRIPS strips. Chips without a packed GRB frame stage their
+    // final pixels at the start of their own region and encode in place.
+    static constexpr uint OUTPUT_POOL_WORDS =
+        NUM_STRIPS * led_driver_grb_words(LEDS_PER_STRIP) +
+        MAX_WIDE_STRIPS * (led_driver_max_words(LEDS_PER_STRIP) - led_driver_grb_words(LEDS_PER_STRIP));
+    std::array<uint32_t, OUTPUT_POOL_WORDS> output_pool;
+    std::array<uint32_t*, NUM_STRIPS> output_words{};
     
-    // Animation state
-    AnimationMode current_animation = AnimationMode::STATIC;
-    uint32_t animation_start_time = 0;
-    uint32_t animation_speed = 100;  // ms per animation step
-    RGB primary_color = RGB(0, 0, 0);
-    RGB secondary_color = RGB(0, 0, 0);
     float brightness = 1.0f;
+    uint32_t brightness_scale = 256;  // brightness in 1/256 steps
+    
+    // Temporal dithering: per-channel fraction carried into the next frame
+    bool dithering = false;
+    std::array<std::array<RGB, LEDS_PER_STRIP>, NUM_STRIPS> dither_error;
     
     // Update tracking
-    bool buffers_dirty[NUM_STRIPS] = {false, false};
-    uint32_t last_update_time = 0;
-    static constexpr uint32_t UPDATE_INTERVAL_MS = 16;  // ~60 FPS
+    bool composite_dirty = true;
+    uint32_t frame_rate_hz = DEFAULT_FRAME_RATE_HZ;
+    static constexpr uint32_t HIGH_REFRESH_RATE_HZ = 250;  // A 60 LED frame is ~1.8ms
+    uint32_t last_render_us = 0;
+    
+    // Sparkle positions; xorshift32, so a seeded sequence is reproducible
+    uint32_t random_state = 0x9E3779B9;
+    uint32_t next_random() {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return random_state;
+    }
     
     // Private methods
     void init();
-    void init_pio();
-    void init_dma();
+    void start_driver(uint strip, LedChip chip, uint32_t* words);
     void prepare_dma_buffer(uint strip_index);
     void trigger_dma_transfer(uint strip_index);
     void update_animations();
-    RGB apply_brightness(const RGB& color) const;
+    void composite();
+    void blend_layer(const Layer& layer);
+    void fill_layer(Layer& layer, const RGB& color);
+    void mark_layer_dirty(Layer& layer);
+    
+    // Zones, drawn over the base layer
+    bool write_zone_run(Zone& zone, uint offset, uint count, const ZoneRun& run);
+    void set_zone_runs(Zone& zone, const ZoneRun* runs, uint count);
+    void animate_zone(Zone& zone, uint32_t now_ms);
+    void expand_zone(const Zone& zone);
+    void update_zones();
     
-    // Animation helpers
-    void animate_rainbow(uint32_t elapsed_ms);
-    void animate_chase(uint32_t elapsed_ms);
-    void animate_pulse(uint32_t elapsed_ms);
-    void animate_sparkle(uint32_t elapsed_ms);
-    void animate_fade(uint32_t elapsed_ms);
+    // Animation helpers, rendering into a layer's strips and range
+    void animate_rainbow(Layer& layer, uint32_t elapsed_ms);
+    void animate_chase(Layer& layer, uint32_t elapsed_ms);
+    void animate_pulse(Layer& layer, uint32_t elapsed_ms);
+    void animate_sparkle(Layer& layer, uint32_t elapsed_ms);
+    void animate_fade(Layer& layer, uint32_t elapsed_ms);
+    void animate_effect(Layer& layer, uint32_t elapsed_ms);
     
 public:
     static WS2812Controller& instance();
     void update(bool force = false);
     
-    // Basic LED control
+    // Renders a frame into the DMA buffers without sending it; full
+    // re-composites every layer. update() uses this, so does bench.
+    void render(bool full = false);
+    
+    // Basic LED control (base layer)
     void set_led(uint strip, uint led_index, const RGB& color);
     void set_led(uint strip, uint led_index, uint8_t r, uint8_t g, uint8_t b);
     void set_strip(uint strip, const RGB& color);
@@ -106,16 +286,43 @@ public:
     
     // Advanced control
     void set_brightness(float brightness);  // 0.0 to 1.0
+    void set_dithering(bool enabled);  // High-refresh mode with temporal dithering
+    void set_frame_rate(uint32_t hz);
+    bool set_strip_chip(uint strip, LedChip chip);  // false past MAX_WIDE_STRIPS wide chips
     void set_range(uint strip, uint start_index, uint count, const RGB& color);
     void set_gradient(uint strip, uint start_index, uint count, const RGB& start_color, const RGB& end_color);
     
-    // Animation control
+    // Animation control (base layer)
     void set_animation(AnimationMode mode, uint32_t speed_ms = 10);
     void set_animation_colors(const RGB& primary, const RGB& secondary);
     
+    // Layer control; the base layer is always enabled
+    void set_layer_enabled(uint layer, bool enabled);
+    void set_layer_animation(uint layer, AnimationMode mode, uint32_t speed_ms = 10);
+    void set_layer_colors(uint layer, const RGB& primary, const RGB& secondary);
+    void set_layer_blend(uint layer, BlendMode mode, uint8_t opacity = 255);
+    void set_layer_mask(uint layer, uint8_t strip_mask, uint start_index = 0, uint count = LEDS_PER_STRIP);
+    void set_layer_fill(uint layer, const RGB& color);
+    void set_layer_effect(uint layer, uint slot);
+    
+    // Zones; offset/count address a part of the zone in zone order
+    bool define_zone(std::string_view name, const ZoneRange* ranges, uint count);
+    bool delete_zone(std::string_view name);
+    int find_zone(std::string_view name) const;
+    bool set_zone_fill(uint zone, uint offset, uint count, const RGB& color);
+    bool set_zone_gradient(uint zone, uint offset, uint count, const RGB& start_color, const RGB& end_color);
+    bool set_zone_animation(uint zone, AnimationMode mode, uint32_t speed_ms, const RGB& primary, const RGB& secondary);
+    const Zone& get_zone(uint zone) const { return zones[zone]; }
+    
     // Status getters
-    AnimationMode get_animation_mode() const { return current_animation; }
+    AnimationMode get_animation_mode() const { return layers[BASE_LAYER].animation; }
+    const Layer& get_layer(uint layer) const { return layers[layer]; }
     float get_brightness() const { return brightness; }
+    bool is_dithering() const { return dithering; }
+    uint32_t get_frame_rate() const { return frame_rate_hz; }
+    uint32_t get_max_frame_rate() const;
+    LedChip get_strip_chip(uint strip) const;
+    uint32_t get_last_render_us() const { return last_render_us; }
     RGB get_led(uint strip, uint led_index) const;
     
     // Utility methods
@@ -123,6 +330,9 @@ public:
     bool is_led_valid(uint strip, uint led_index) const { 
         return is_strip_valid(strip) && led_index < LEDS_PER_STRIP; 
     }
+    bool is_layer_valid(uint layer) const { return layer < MAX_LAYERS; }
+    bool is_zone_valid(uint zone) const { return zone < MAX_ZONES && zones[zone].in_use(); }
+    void seed_random(uint32_t seed) { random_state = seed ? seed : 1; }
     
 };
 
@@ -2,6 +2,9 @@
 #include "ws2812.pio.h"
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
+#include "pio_manager.h"
+
+static constexpr float WS2812_FREQ = 800000;
 
 WS2812Led& WS2812Led::instance() {
     static WS2812Led led;
@@ -13,8 +16,13 @@ WS2812Led& WS2812Led::instance() {
 }
 
 void WS2812Led::init() {
-    uint offset = pio_add_program(pio, &ws2812_program);
-    ws2812_program_init(pio, sm, offset, PICO_DEFAULT_WS2812_PIN, 800000, false);
+    // Shares the ws2812 program copy with the strips when a state machine is free
+    const int cycles_per_bit = ws2812_T1 + ws2812_T2 + ws2812_T3;
+    PioAllocation allocation = PioManager::instance().claim_sm(&ws2812_program, "ws2812", "status",
+                                                               WS2812_FREQ * cycles_per_bit, true);
+    pio = allocation.pio;
+    sm = allocation.sm;
+    ws2812_program_init(pio, sm, allocation.offset, PICO_DEFAULT_WS2812_PIN, WS2812_FREQ, false);
 }
 
 void WS2812Led::set_color(uint8_t red, uint8_t green, uint8_t blue) {
@@ -21,7 +21,7 @@ private:
     void init();
     void put_pixel(uint32_t pixel_grb);
     
-    PIO pio = pio1;
+    PIO pio = nullptr;
     uint sm = 0;
 };
 